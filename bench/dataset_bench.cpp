@@ -0,0 +1,274 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "concurrent_env.hpp"
+#include "env.hpp"
+#include "env_dataset.hpp"
+
+namespace
+{
+    using dot_env_bench::dataset;
+
+    /**
+     * Runs body with the dataset's directory as the working directory, so
+     * load_env(".env") picks up its file.
+     */
+    template <typename Body>
+    void in_dataset(const dataset& set, Body&& body)
+    {
+        const auto previous = std::filesystem::current_path();
+        std::filesystem::current_path(dot_env_bench::dataset_directory(set));
+        body();
+        std::filesystem::current_path(previous);
+    }
+
+    [[nodiscard]] std::int64_t file_bytes(const dataset& set)
+    {
+        return static_cast<std::int64_t>(std::filesystem::file_size(
+            dot_env_bench::dataset_directory(set) / ".env"));
+    }
+
+    /**
+     * A deferred-injection env holding the dataset, loaded once per dataset.
+     */
+    const dot_env::env& loaded(const dataset& set)
+    {
+        static std::map<std::string_view, dot_env::env> cache;
+        if (const auto it = cache.find(set.name); it != cache.end())
+            return it->second;
+
+        auto& environment = cache[set.name];
+        environment.set_injection(dot_env::injection_mode::deferred);
+        in_dataset(set, [&] { environment.load_env(".env", false); });
+        return environment;
+    }
+
+    /**
+     * Keys of the given kind (see dot_env_bench::dataset), in an order
+     * that defeats the prefetcher so lookups miss the caches like a cold
+     * start would. A warm run uses just the first few of them.
+     */
+    const std::vector<std::string>& keys_of_kind(const dataset& set,
+                                                 const std::size_t kind)
+    {
+        static std::map<std::pair<std::string_view, std::size_t>,
+                        std::vector<std::string>>
+            cache;
+        auto& keys = cache[{set.name, kind}];
+        if (keys.empty())
+        {
+            for (std::size_t i = kind; i < set.entries; i += 4)
+                keys.push_back(dot_env_bench::dataset_key(i));
+            std::ranges::shuffle(keys, std::mt19937_64(set.entries));
+        }
+        return keys;
+    }
+
+    constexpr std::size_t warm_keys = 64;
+
+    [[nodiscard]] std::size_t working_set(const benchmark::State& state,
+                                          const std::vector<std::string>& keys)
+    {
+        return state.range(0) == 0 ? keys.size()
+                                   : std::min(keys.size(), warm_keys);
+    }
+
+    void BM_load(benchmark::State& state, const dataset set, const unsigned threads)
+    {
+        in_dataset(set, [&]
+        {
+            for (auto _ : state)
+            {
+                dot_env::env environment;
+                environment.set_injection(dot_env::injection_mode::deferred);
+                environment.set_parse_threads(threads);
+                benchmark::DoNotOptimize(environment.load_env(".env", false));
+            }
+        });
+        state.SetItemsProcessed(state.iterations() *
+                                static_cast<std::int64_t>(set.entries));
+        state.SetBytesProcessed(state.iterations() * file_bytes(set));
+    }
+
+    void BM_load_binary_cache(benchmark::State& state, const dataset set)
+    {
+        in_dataset(set, [&]
+        {
+            if (!loaded(set).freeze().save_cache(".env.bin", ".env"))
+            {
+                state.SkipWithError("cannot write the binary cache");
+                return;
+            }
+            for (auto _ : state)
+            {
+                dot_env::env environment;
+                environment.set_injection(dot_env::injection_mode::deferred);
+                environment.set_binary_cache(true);
+                benchmark::DoNotOptimize(environment.load_env(".env", false));
+            }
+            std::filesystem::remove(".env.bin");
+        });
+        state.SetItemsProcessed(state.iterations() *
+                                static_cast<std::int64_t>(set.entries));
+    }
+
+    void BM_concurrent_load_binary_cache(benchmark::State& state, const dataset set)
+    {
+        in_dataset(set, [&]
+        {
+            if (!loaded(set).freeze().save_cache(".env.bin", ".env"))
+            {
+                state.SkipWithError("cannot write the binary cache");
+                return;
+            }
+            for (auto _ : state)
+            {
+                dot_env::concurrent_env shared;
+                shared.set_binary_cache(true);
+                benchmark::DoNotOptimize(shared.load_env(".env"));
+            }
+            std::filesystem::remove(".env.bin");
+        });
+        state.SetItemsProcessed(state.iterations() *
+                                static_cast<std::int64_t>(set.entries));
+    }
+
+    // Arg 0 is cold, looking up every key of the dataset; 1 is warm,
+    // cycling through a few keys that stay cached
+    void BM_get(benchmark::State& state, const dataset set)
+    {
+        const auto& environment = loaded(set);
+        const auto& keys = keys_of_kind(set, 3);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(environment.get_view(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_ne_int(benchmark::State& state, const dataset set)
+    {
+        // Typed getters cache their parse on the entry, hence the copy
+        auto environment = loaded(set);
+        const auto& keys = keys_of_kind(set, 0);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(environment.get_ne<int>(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_as_duration(benchmark::State& state, const dataset set)
+    {
+        auto environment = loaded(set);
+        const auto& keys = keys_of_kind(set, 1);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(
+                environment.get_as<std::chrono::milliseconds>(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_as_bool(benchmark::State& state, const dataset set)
+    {
+        auto environment = loaded(set);
+        const auto& keys = keys_of_kind(set, 2);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(environment.get_as<bool>(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_snapshot_get(benchmark::State& state, const dataset set)
+    {
+        const auto snapshot = loaded(set).freeze();
+        const auto& keys = keys_of_kind(set, 3);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(snapshot.get_view(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_mapped_snapshot_get(benchmark::State& state, const dataset set)
+    {
+        std::optional<dot_env::env_snapshot> snapshot;
+        in_dataset(set, [&]
+        {
+            if (loaded(set).freeze().save_cache(".env.bin", ".env"))
+                snapshot = dot_env::env_snapshot::open_cache(".env.bin", ".env");
+            std::filesystem::remove(".env.bin");
+        });
+        if (!snapshot.has_value())
+        {
+            state.SkipWithError("cannot map the binary cache");
+            return;
+        }
+
+        const auto& keys = keys_of_kind(set, 3);
+        const std::size_t count = working_set(state, keys);
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(snapshot->get_view(keys[i++ % count]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+} // namespace
+
+BENCHMARK_CAPTURE(BM_load, small, dot_env_bench::small, 1);
+BENCHMARK_CAPTURE(BM_load, medium, dot_env_bench::medium, 1);
+BENCHMARK_CAPTURE(BM_load, long_values, dot_env_bench::long_values, 1);
+BENCHMARK_CAPTURE(BM_load, quoted, dot_env_bench::quoted, 1);
+BENCHMARK_CAPTURE(BM_load, commented, dot_env_bench::commented, 1);
+BENCHMARK_CAPTURE(BM_load, duplicates, dot_env_bench::duplicates, 1);
+BENCHMARK_CAPTURE(BM_load, huge, dot_env_bench::huge, 1)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_load, huge_parallel, dot_env_bench::huge, 0)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_load_binary_cache, huge, dot_env_bench::huge)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_concurrent_load_binary_cache, huge, dot_env_bench::huge)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_get, huge, dot_env_bench::huge)->ArgName("warm")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(BM_get_ne_int, huge, dot_env_bench::huge)->ArgName("warm")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(BM_get_as_duration, huge, dot_env_bench::huge)
+    ->ArgName("warm")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_CAPTURE(BM_get_as_bool, huge, dot_env_bench::huge)
+    ->ArgName("warm")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_CAPTURE(BM_snapshot_get, huge, dot_env_bench::huge)
+    ->ArgName("warm")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_CAPTURE(BM_mapped_snapshot_get, huge, dot_env_bench::huge)
+    ->ArgName("warm")
+    ->Arg(0)
+    ->Arg(1);
@@ -0,0 +1,308 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "concurrent_env.hpp"
+#include "env.hpp"
+
+namespace
+{
+    constexpr std::size_t key_count = 1024;
+
+    // Long enough to defeat the small-string optimization of every major
+    // standard library, which is where per-lookup allocations used to show.
+    std::string make_key(const std::string_view prefix, const std::size_t i)
+    {
+        return std::string(prefix) + "_SERVICE_CONFIGURATION_KEY_" +
+            std::to_string(i);
+    }
+
+    /**
+     * Writes a generated .env file into a scratch directory and loads it,
+     * restoring the working directory afterwards.
+     */
+    class loaded_env
+    {
+    public:
+        loaded_env()
+        {
+            const auto dir = std::filesystem::temp_directory_path() /
+                "dot_env_bench";
+            std::filesystem::create_directories(dir);
+
+            {
+                std::ofstream file(dir / ".env", std::ios::trunc);
+                for (std::size_t i = 0; i < key_count; ++i)
+                {
+                    file << make_key("HIT", i) << "=" << i << '\n';
+                }
+            }
+
+            const auto previous = std::filesystem::current_path();
+            std::filesystem::current_path(dir);
+            environment.load_env(".env", false);
+            std::filesystem::current_path(previous);
+
+            for (std::size_t i = 0; i < key_count; ++i)
+            {
+                hits.push_back(make_key("HIT", i));
+                misses.push_back(make_key("MISS", i));
+                system.push_back(make_key("SYSTEM", i));
+#ifdef _WIN32
+                _putenv_s(system.back().c_str(), "system_value");
+#else
+                setenv(system.back().c_str(), "system_value", 1);
+#endif
+            }
+        }
+
+        dot_env::env environment;
+        std::vector<std::string> hits;
+        std::vector<std::string> misses;
+        std::vector<std::string> system;
+    };
+
+    loaded_env& fixture()
+    {
+        static loaded_env instance;
+        return instance;
+    }
+
+    void run_lookups(benchmark::State& state,
+                     const std::vector<std::string>& keys)
+    {
+        auto& environment = fixture().environment;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(environment.get(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_hit(benchmark::State& state)
+    {
+        run_lookups(state, fixture().hits);
+    }
+
+    void BM_get_miss(benchmark::State& state)
+    {
+        run_lookups(state, fixture().misses);
+    }
+
+    void BM_get_system_fallback(benchmark::State& state)
+    {
+        run_lookups(state, fixture().system);
+    }
+
+    void BM_get_view_system_captured(benchmark::State& state)
+    {
+        static const dot_env::env environment = []
+        {
+            // Capture after the fixture has set its system variables
+            dot_env::env captured = fixture().environment;
+            captured.capture_system_environment();
+            return captured;
+        }();
+        const auto& keys = fixture().system;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(environment.get_view(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_view_hit(benchmark::State& state)
+    {
+        auto& environment = fixture().environment;
+        const auto& keys = fixture().hits;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(environment.get_view(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_ne_hit(benchmark::State& state)
+    {
+        auto& environment = fixture().environment;
+        const auto& keys = fixture().hits;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(environment.get_ne<int>(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    void BM_snapshot_get_view_hit(benchmark::State& state)
+    {
+        static const auto snapshot = fixture().environment.freeze();
+        const auto& keys = fixture().hits;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(snapshot.get_view(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_snapshot_get_view_miss(benchmark::State& state)
+    {
+        static const auto snapshot = fixture().environment.freeze();
+        const auto& keys = fixture().misses;
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(snapshot.get_view(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_snapshot_get_view_hashed_hit(benchmark::State& state)
+    {
+        static const auto snapshot = fixture().environment.freeze();
+        static const auto keys = []
+        {
+            std::vector<dot_env::hashed_key> hashed;
+            for (const auto& key : fixture().hits)
+                hashed.emplace_back(key);
+            return hashed;
+        }();
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(snapshot.get_view(keys[i++ % keys.size()]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_snapshot_with_prefix(benchmark::State& state)
+    {
+        static const auto snapshot = fixture().environment.freeze();
+        // Matches the 11 keys ending in 51 and 510 to 519
+        const std::string prefix = make_key("HIT", 51);
+        for (auto _ : state)
+        {
+            std::size_t bytes = 0;
+            for (const auto [name, value] : snapshot.with_prefix(prefix))
+                bytes += value.size();
+            benchmark::DoNotOptimize(bytes);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_get_ne_static_key(benchmark::State& state)
+    {
+        auto& environment = fixture().environment;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(environment.get_ne<int>(
+                dot_env::key<"HIT_SERVICE_CONFIGURATION_KEY_512">));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_concurrent_get_ne_hit(benchmark::State& state)
+    {
+        static dot_env::concurrent_env shared(fixture().environment.freeze());
+        const auto& keys = fixture().hits;
+        std::size_t i = static_cast<std::size_t>(state.thread_index());
+        for (auto _ : state)
+        {
+            const std::string_view key = keys[i++ % keys.size()];
+            benchmark::DoNotOptimize(shared.get_ne<int>(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_load_env(benchmark::State& state, const bool use_arena,
+                     const dot_env::injection_mode injection)
+    {
+        const auto entries = static_cast<std::size_t>(state.range(0));
+        const auto dir = std::filesystem::temp_directory_path() /
+            "dot_env_bench_load";
+        std::filesystem::create_directories(dir);
+        {
+            std::ofstream file(dir / ".env", std::ios::trunc);
+            for (std::size_t i = 0; i < entries; ++i)
+            {
+                file << make_key("LOAD", i) << " = \"value_" << i << "\"\n";
+            }
+        }
+
+        const auto bytes = std::filesystem::file_size(dir / ".env");
+        const auto previous = std::filesystem::current_path();
+        std::filesystem::current_path(dir);
+        for (auto _ : state)
+        {
+            if (use_arena)
+            {
+                std::pmr::monotonic_buffer_resource arena(bytes * 2);
+                dot_env::env environment(&arena);
+                environment.set_injection(injection);
+                benchmark::DoNotOptimize(environment.load_env(".env", true));
+            }
+            else
+            {
+                dot_env::env environment;
+                environment.set_injection(injection);
+                benchmark::DoNotOptimize(environment.load_env(".env", true));
+            }
+        }
+        std::filesystem::current_path(previous);
+
+        state.SetItemsProcessed(state.iterations() *
+                                static_cast<std::int64_t>(entries));
+        state.SetBytesProcessed(state.iterations() *
+                                static_cast<std::int64_t>(bytes));
+    }
+} // namespace
+
+// Eager loads call setenv per key, which is quadratic on glibc, so they
+// stop at 10k entries
+BENCHMARK_CAPTURE(BM_load_env, heap, false, dot_env::injection_mode::eager)
+    ->Arg(1'000)
+    ->Arg(10'000);
+BENCHMARK_CAPTURE(BM_load_env, arena, true, dot_env::injection_mode::eager)
+    ->Arg(1'000)
+    ->Arg(10'000);
+BENCHMARK_CAPTURE(BM_load_env, heap_deferred, false,
+                  dot_env::injection_mode::deferred)
+    ->Arg(1'000)
+    ->Arg(10'000)
+    ->Arg(100'000);
+BENCHMARK_CAPTURE(BM_load_env, arena_deferred, true,
+                  dot_env::injection_mode::deferred)
+    ->Arg(1'000)
+    ->Arg(10'000)
+    ->Arg(100'000);
+BENCHMARK(BM_get_hit);
+BENCHMARK(BM_get_miss);
+BENCHMARK(BM_get_system_fallback);
+BENCHMARK(BM_get_view_system_captured);
+BENCHMARK(BM_get_view_hit);
+BENCHMARK(BM_get_ne_hit);
+BENCHMARK(BM_snapshot_get_view_hit);
+BENCHMARK(BM_snapshot_get_view_miss);
+BENCHMARK(BM_snapshot_get_view_hashed_hit);
+BENCHMARK(BM_snapshot_with_prefix);
+BENCHMARK(BM_get_ne_static_key);
+BENCHMARK(BM_concurrent_get_ne_hit)->ThreadRange(1, 8);
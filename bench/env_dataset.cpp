@@ -0,0 +1,106 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "env_dataset.hpp"
+
+#include <array>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace dot_env_bench
+{
+    namespace
+    {
+        constexpr std::array all_datasets{small,  medium,    huge,      long_values,
+                                          quoted, commented, duplicates};
+
+        void append_value(std::string& out, const dataset& set, const std::size_t i)
+        {
+            switch (i % 4)
+            {
+            case 0:
+                out += std::to_string(i * 7919 % 1'000'003);
+                break;
+            case 1:
+                out += std::to_string(i % 10'000) + "ms";
+                break;
+            case 2:
+                out += i % 8 == 2 ? "true" : "off";
+                break;
+            default:
+                {
+                    const bool quote = i % 100 < set.quoted_percent;
+                    if (quote)
+                        out += '"';
+
+                    const std::size_t start = out.size();
+                    out += "value " + std::to_string(i) + ' ';
+                    // Pad with a repeating alphabet up to the requested length
+                    for (std::size_t c = out.size() - start; c < set.value_length; ++c)
+                        out += static_cast<char>('a' + (i + c) % 26);
+                    if (out.size() - start > set.value_length && set.value_length != 0)
+                        out.resize(start + set.value_length);
+
+                    if (quote)
+                        out += '"';
+                }
+                break;
+            }
+        }
+    } // namespace
+
+    std::span<const dataset> datasets() noexcept
+    {
+        return all_datasets;
+    }
+
+    std::string dataset_key(const std::size_t i)
+    {
+        return "SERVICE_CONFIGURATION_KEY_" + std::to_string(i);
+    }
+
+    std::string generate(const dataset& set)
+    {
+        std::string out;
+        out.reserve(set.entries * (set.value_length / 4 + 48));
+        for (std::size_t i = 0; i < set.entries; ++i)
+        {
+            if (set.comment_every != 0 && i % set.comment_every == 0)
+                out += "# settings for shard " + std::to_string(i / 64) + '\n';
+
+            out += dataset_key(i);
+            out += i % 2 == 0 ? "=" : " = ";
+            append_value(out, set, i);
+            out += '\n';
+
+            // Redefine a key of the same kind, so its type stays the same
+            if (i >= 4 && i % 100 < set.duplicate_percent)
+            {
+                out += dataset_key(i - 4) + '=';
+                append_value(out, set, i);
+                out += '\n';
+            }
+        }
+        return out;
+    }
+
+    const std::filesystem::path& dataset_directory(const dataset& set)
+    {
+        static std::map<std::string_view, std::filesystem::path> written;
+        if (const auto it = written.find(set.name); it != written.end())
+            return it->second;
+
+        auto dir = std::filesystem::temp_directory_path() / "dot_env_bench_data" / set.name;
+        std::filesystem::create_directories(dir);
+        {
+            const auto text = generate(set);
+            std::ofstream file(dir / ".env", std::ios::binary | std::ios::trunc);
+            file.write(text.data(), static_cast<std::streamsize>(text.size()));
+            if (!file.flush())
+                throw std::runtime_error("cannot write " + (dir / ".env").string());
+        }
+        return written.emplace(set.name, std::move(dir)).first->second;
+    }
+} // namespace dot_env_bench
@@ -0,0 +1,69 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_DATASET_HPP
+#define ENV_DATASET_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace dot_env_bench
+{
+    /**
+     * The shape of a generated .env file. Generation is deterministic, so
+     * the same dataset always produces the same bytes.
+     *
+     * Entry i cycles through four kinds of value: an integer (i % 4 == 0),
+     * a duration (1), a bool (2) and free text of value_length characters
+     * (3), so typed getters can be measured on keys whose type is known.
+     */
+    struct dataset
+    {
+        std::string_view name;
+        std::size_t entries;
+        // Length of the free text values
+        std::size_t value_length;
+        // Share of free text values written in double quotes
+        unsigned quoted_percent;
+        // A comment line before every n-th entry, 0 for none
+        std::size_t comment_every;
+        // Share of entries followed by a redefinition of an earlier key
+        unsigned duplicate_percent;
+    };
+
+    inline constexpr dataset small{"small", 100, 16, 25, 10, 0};
+    inline constexpr dataset medium{"medium", 10'000, 16, 25, 10, 0};
+    inline constexpr dataset huge{"huge", 1'000'000, 16, 25, 10, 0};
+    inline constexpr dataset long_values{"long_values", 10'000, 512, 25, 10, 0};
+    inline constexpr dataset quoted{"quoted", 10'000, 16, 100, 0, 0};
+    inline constexpr dataset commented{"commented", 10'000, 16, 0, 1, 0};
+    inline constexpr dataset duplicates{"duplicates", 10'000, 16, 25, 10, 25};
+
+    /**
+     * All the predefined datasets, smallest first.
+     */
+    [[nodiscard]] std::span<const dataset> datasets() noexcept;
+
+    /**
+     * The name of entry i. Long enough to defeat the small-string
+     * optimization, like real service configuration keys.
+     */
+    [[nodiscard]] std::string dataset_key(std::size_t i);
+
+    /**
+     * Returns the .env text described by set.
+     */
+    [[nodiscard]] std::string generate(const dataset& set);
+
+    /**
+     * Writes the dataset to its own scratch directory on first use and
+     * returns the directory; the file inside is always named ".env".
+     */
+    [[nodiscard]] const std::filesystem::path& dataset_directory(const dataset& set);
+} // namespace dot_env_bench
+
+#endif // ENV_DATASET_HPP
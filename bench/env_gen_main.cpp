@@ -0,0 +1,54 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+#include "env_dataset.hpp"
+
+/**
+ * dot_env_gen DATASET [OUTPUT]
+ *
+ * Writes one of the benchmark datasets to OUTPUT, or to the standard output,
+ * so the same inputs can be fed to other tools or to an older build.
+ */
+int main(const int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "usage: dot_env_gen DATASET [OUTPUT]\ndatasets:";
+        for (const auto& set : dot_env_bench::datasets())
+            std::cerr << ' ' << set.name;
+        std::cerr << '\n';
+        return EXIT_FAILURE;
+    }
+
+    const std::string_view name = argv[1];
+    for (const auto& set : dot_env_bench::datasets())
+    {
+        if (set.name != name)
+            continue;
+
+        const auto text = dot_env_bench::generate(set);
+        if (argc == 2)
+        {
+            std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return std::cout.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!out.flush())
+        {
+            std::cerr << "dot_env_gen: cannot write " << argv[2] << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << "dot_env_gen: unknown dataset " << name << '\n';
+    return EXIT_FAILURE;
+}
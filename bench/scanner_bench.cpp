@@ -0,0 +1,225 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "parser.hpp"
+#include "scanner.hpp"
+
+namespace
+{
+    using dot_env::detail::scan_backend;
+
+    /**
+     * Returns a generated .env buffer of roughly the given size in MiB.
+     * Buffers are built once per size and reused across benchmarks.
+     */
+    const std::string& generated_buffer(const std::int64_t mebibytes)
+    {
+        static std::map<std::int64_t, std::string> cache;
+        auto& buffer = cache[mebibytes];
+        if (buffer.empty())
+        {
+            const auto target = static_cast<std::size_t>(mebibytes) << 20;
+            buffer.reserve(target + 128);
+            for (std::size_t i = 0; buffer.size() < target; ++i)
+            {
+                if (i % 16 == 0)
+                    buffer += "# feature flags for shard " + std::to_string(i) +
+                        '\n';
+
+                buffer += "FEATURE_FLAG_" + std::to_string(i) + " = ";
+                if (i % 3 == 0)
+                    buffer += "\"enabled for cohort " + std::to_string(i) + '"';
+                else
+                    buffer += std::to_string(i * 7919);
+                buffer += '\n';
+            }
+        }
+        return buffer;
+    }
+
+    constexpr std::string_view whitespace = " \t\r\n";
+
+    std::string_view trim_reference(const std::string_view text)
+    {
+        const auto first = text.find_first_not_of(whitespace);
+        if (first == std::string_view::npos)
+            return {};
+
+        const auto last = text.find_last_not_of(whitespace);
+        return text.substr(first, last - first + 1);
+    }
+
+    /**
+     * The pre-scanner line loop: find_first_not_of/find_last_not_of trims
+     * and a plain find('=') per line, working on views so only the search
+     * strategy differs from detail::tokenize.
+     */
+    std::size_t tokenize_reference(const std::string_view buffer)
+    {
+        std::size_t count = 0;
+        std::size_t pos = 0;
+        while (pos < buffer.size())
+        {
+            auto line_end = buffer.find('\n', pos);
+            if (line_end == std::string_view::npos)
+                line_end = buffer.size();
+
+            const auto line =
+                trim_reference(buffer.substr(pos, line_end - pos));
+            pos = line_end + 1;
+
+            if (line.empty() || line.front() == '#')
+                continue;
+
+            const auto eq_pos = line.find('=');
+            if (eq_pos == std::string_view::npos)
+                continue;
+
+            const auto key = trim_reference(line.substr(0, eq_pos));
+            const auto value = trim_reference(line.substr(eq_pos + 1));
+            benchmark::DoNotOptimize(key);
+            benchmark::DoNotOptimize(value);
+            ++count;
+        }
+        return count;
+    }
+
+    void set_throughput(benchmark::State& state, const std::string& buffer)
+    {
+        state.SetBytesProcessed(state.iterations() *
+                                static_cast<std::int64_t>(buffer.size()));
+    }
+
+    void BM_tokenize_reference(benchmark::State& state)
+    {
+        const auto& buffer = generated_buffer(state.range(0));
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(tokenize_reference(buffer));
+        }
+        set_throughput(state, buffer);
+    }
+
+    void BM_tokenize_scanner(benchmark::State& state)
+    {
+        const auto& buffer = generated_buffer(state.range(0));
+        for (auto _ : state)
+        {
+            std::size_t count = 0;
+            dot_env::detail::tokenize(
+                buffer,
+                [&](const dot_env::detail::token& token)
+                {
+                    benchmark::DoNotOptimize(token);
+                    ++count;
+                },
+                [](std::string_view, std::size_t) {});
+            benchmark::DoNotOptimize(count);
+        }
+        set_throughput(state, buffer);
+    }
+
+    void BM_find_delimiters(benchmark::State& state,
+                            const scan_backend backend)
+    {
+        if (!dot_env::detail::scan_backend_available(backend))
+        {
+            state.SkipWithError("backend not available on this machine");
+            return;
+        }
+
+        constexpr dot_env::detail::delimiter_set delimiters("\n=#\"");
+        const auto& buffer = generated_buffer(state.range(0));
+        for (auto _ : state)
+        {
+            std::size_t count = 0;
+            for (std::size_t pos = dot_env::detail::find_first_of(
+                     buffer, 0, delimiters, backend);
+                 pos < buffer.size();
+                 pos = dot_env::detail::find_first_of(buffer, pos + 1,
+                                                      delimiters, backend))
+            {
+                ++count;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        set_throughput(state, buffer);
+    }
+
+    void BM_split_lines(benchmark::State& state, const scan_backend backend)
+    {
+        if (!dot_env::detail::scan_backend_available(backend))
+        {
+            state.SkipWithError("backend not available on this machine");
+            return;
+        }
+
+        const auto& buffer = generated_buffer(state.range(0));
+        for (auto _ : state)
+        {
+            std::size_t assignments = 0;
+            for (std::size_t pos = 0; pos < buffer.size();)
+            {
+                const auto split =
+                    dot_env::detail::split_line(buffer, pos, backend);
+                assignments += split.assignment != std::string_view::npos;
+                pos = split.end + 1;
+            }
+            benchmark::DoNotOptimize(assignments);
+        }
+        set_throughput(state, buffer);
+    }
+} // namespace
+
+BENCHMARK(BM_tokenize_reference)->Arg(1)->Arg(10)->Arg(100)->Unit(
+    benchmark::kMillisecond);
+BENCHMARK(BM_tokenize_scanner)->Arg(1)->Arg(10)->Arg(100)->Unit(
+    benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_find_delimiters, scalar, scan_backend::scalar)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_find_delimiters, sse2, scan_backend::sse2)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_find_delimiters, avx2, scan_backend::avx2)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_find_delimiters, neon, scan_backend::neon)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_split_lines, scalar, scan_backend::scalar)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_split_lines, sse2, scan_backend::sse2)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_split_lines, avx2, scan_backend::avx2)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_split_lines, neon, scan_backend::neon)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
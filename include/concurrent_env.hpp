@@ -0,0 +1,272 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef CONCURRENT_ENV_HPP
+#define CONCURRENT_ENV_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "env_parse.hpp"
+#include "env_snapshot.hpp"
+
+namespace dot_env
+{
+    /**
+     * Environment variable store for multi-threaded readers with atomic
+     * reloads.
+     *
+     * The current variables are held as an immutable env_snapshot behind an
+     * atomic shared pointer. Readers only load that pointer and probe the
+     * snapshot, so they never wait for a reload's file I/O or parse: a
+     * reload builds a fresh snapshot off to the side and then publishes it
+     * with a single atomic store. Every reader sees either the complete old
+     * set or the complete new set of variables. The pointer load itself is
+     * not guaranteed to be lock-free; standard libraries typically guard
+     * std::atomic<std::shared_ptr> with a short internal lock held only for
+     * the reference count update.
+     *
+     * Unlike env, loading never calls setenv/_putenv_s. Mutating the
+     * process environment would race with getenv in other threads, which is
+     * exactly what this class exists to avoid. Lookups likewise only consult
+     * the published snapshot, never the process environment.
+     */
+    class concurrent_env
+    {
+    public:
+        concurrent_env();
+
+        /**
+         * Creates a store that initially publishes the given snapshot.
+         *
+         * @param initial The variables readers see until the first reload.
+         */
+        explicit concurrent_env(env_snapshot initial);
+
+        concurrent_env(const concurrent_env&) = delete;
+        concurrent_env& operator=(const concurrent_env&) = delete;
+
+        /**
+         * Loads environment variables from a file and publishes them as the
+         * new current snapshot, replacing all previously published values.
+         *
+         * The file is located the same way as env::load_env(). Readers keep
+         * seeing the previous snapshot until parsing has finished. If the
+         * file cannot be found, nothing is published.
+         *
+         * With set_binary_cache() enabled, a binary cache (the file name
+         * with ".bin" appended, see env_snapshot::save_cache()) that exists
+         * and still matches the file is memory-mapped and published
+         * directly instead of parsing the text, so lookups read straight
+         * from the mapping.
+         *
+         * @param filename The name of the file to load environment variables
+         * from. If not specified, defaults to ".env".
+         * @return Returns true if the file was found and a new snapshot was
+         * published, otherwise returns false.
+         */
+        bool load_env(std::string_view filename = ".env");
+
+        /**
+         * Lets load_env() use a binary cache compiled from the file, see
+         * env::set_binary_cache(). Disabled by default; the cache is never
+         * written implicitly.
+         *
+         * @param enabled Whether subsequent loads consult the cache.
+         */
+        void set_binary_cache(const bool enabled) noexcept
+        {
+            binary_cache_.store(enabled, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool binary_cache() const noexcept
+        {
+            return binary_cache_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Loads several files as layers, merged the same way as
+         * env::load_layers(), and publishes the result as one snapshot.
+         *
+         * Readers switch from the previous snapshot straight to the fully
+         * merged one; no intermediate state with only some of the layers
+         * applied is ever visible. If none of the files exist, nothing is
+         * published.
+         *
+         * @param filenames The layers, lowest precedence first.
+         * @return The number of layers that were found and parsed.
+         */
+        std::size_t load_layers(std::span<const std::string_view> filenames);
+
+        std::size_t load_layers(const std::initializer_list<std::string_view> filenames)
+        {
+            return load_layers(std::span(filenames.begin(), filenames.size()));
+        }
+
+        /**
+         * Runs load_env() on a separate thread, so a service can start
+         * accepting work while a large file is still being read and parsed.
+         *
+         * Readers keep seeing the previous snapshot, or an empty one, until
+         * the task publishes. The file name is resolved against the working
+         * directory at the time of the call. This store must outlive the
+         * task; like any std::async future, the returned one blocks in its
+         * destructor until the load has finished.
+         *
+         * @param filename The name of the file to load environment variables
+         * from. If not specified, defaults to ".env".
+         * @return A future holding the result of load_env().
+         */
+        [[nodiscard]] std::future<bool> load_env_async(std::string_view filename = ".env");
+
+        /**
+         * Runs load_layers() on a separate thread, see load_env_async().
+         *
+         * @param filenames The layers, lowest precedence first.
+         * @return A future holding the result of load_layers().
+         */
+        [[nodiscard]] std::future<std::size_t>
+        load_layers_async(std::span<const std::string_view> filenames);
+
+        [[nodiscard]] std::future<std::size_t>
+        load_layers_async(const std::initializer_list<std::string_view> filenames)
+        {
+            return load_layers_async(std::span(filenames.begin(), filenames.size()));
+        }
+
+        /**
+         * Returns the path of the file most recently published by
+         * load_env().
+         *
+         * @return The resolved path, or an empty path if nothing has been
+         * loaded from a file yet.
+         */
+        [[nodiscard]] std::filesystem::path source_path() const;
+
+        /**
+         * Returns how many files the current snapshot was merged from: 1
+         * after load_env(), the number of layers found after load_layers(),
+         * and 0 if nothing has been loaded from a file yet.
+         */
+        [[nodiscard]] std::size_t source_layers() const;
+
+        /**
+         * Atomically replaces the current snapshot.
+         *
+         * @param snapshot The new set of variables.
+         * @return The snapshot that was current before, e.g. for computing
+         * an env_snapshot::diff().
+         */
+        std::shared_ptr<const env_snapshot> publish(env_snapshot snapshot);
+
+        /**
+         * Returns the currently published snapshot.
+         *
+         * Holding on to the returned pointer keeps that generation alive,
+         * so views obtained from it stay valid across concurrent reloads.
+         *
+         * @return The current snapshot; never null.
+         */
+        [[nodiscard]] std::shared_ptr<const env_snapshot>
+        snapshot() const noexcept
+        {
+            return current_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Retrieves a copy of the value stored for key in the current
+         * snapshot.
+         *
+         * A copy is returned because a view could be invalidated by a
+         * concurrent reload; use snapshot() to read several values without
+         * copying.
+         *
+         * @param key The name of the environment variable to retrieve.
+         * @return The value if present; otherwise std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string>
+        get(const std::string_view key) const
+        {
+            return snapshot()->get(key);
+        }
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Retrieves the value stored for key in the current snapshot, parsed
+         * as an arithmetic type in native-endian byte order.
+         *
+         * @tparam T The arithmetic type to parse the value as.
+         * @param key The name of the environment variable to retrieve.
+         * @return The parsed value if present and valid; otherwise
+         * std::nullopt.
+         */
+        [[nodiscard]] std::optional<T> get_ne(const std::string_view key) const
+        {
+            return snapshot()->get_ne<T>(key);
+        }
+
+        [[nodiscard]] std::optional<std::string>
+        get(const hashed_key& key) const
+        {
+            return snapshot()->get(key);
+        }
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Same as get_ne(std::string_view), but probes the snapshot with the
+         * key's precomputed hash.
+         */
+        [[nodiscard]] std::optional<T> get_ne(const hashed_key& key) const
+        {
+            return snapshot()->get_ne<T>(key);
+        }
+
+        template <typename T>
+            requires parseable<T> && (!borrows_text<T>)
+        /**
+         * Retrieves the value stored for key in the current snapshot, parsed
+         * with parse_traits<T>. Types that borrow the text are rejected,
+         * since a concurrent reload could free it; parse them from a pinned
+         * snapshot() instead.
+         *
+         * @tparam T The type to parse the value as.
+         * @param key The name of the environment variable to retrieve.
+         * @return The parsed value if present and valid; otherwise
+         * std::nullopt.
+         */
+        [[nodiscard]] std::optional<T> get_as(const std::string_view key) const
+        {
+            return snapshot()->get_as<T>(key);
+        }
+
+        template <typename T>
+            requires parseable<T> && (!borrows_text<T>)
+        [[nodiscard]] std::optional<T> get_as(const hashed_key& key) const
+        {
+            return snapshot()->get_as<T>(key);
+        }
+
+    private:
+        std::atomic<std::shared_ptr<const env_snapshot>> current_;
+        // Serializes writers only; readers never touch it
+        mutable std::mutex reload_mutex_;
+        std::filesystem::path source_path_ = {};
+        std::size_t source_layers_ = 0;
+        std::atomic<bool> binary_cache_ = false;
+    };
+} // namespace dot_env
+
+#endif // CONCURRENT_ENV_HPP
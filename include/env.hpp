@@ -5,24 +5,228 @@
 #ifndef ENV_HPP
 #define ENV_HPP
 
-#include <complex>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "env_diagnostics.hpp"
+#include "env_key.hpp"
+#include "env_parse.hpp"
+#include "env_snapshot.hpp"
+#include "env_stats.hpp"
+#include "env_traits.hpp"
 
 namespace dot_env
 {
+    /**
+     * Transparent hasher for string keys.
+     *
+     * Declares is_transparent so that unordered containers using it together
+     * with std::equal_to<> accept std::string_view (and const char*) lookups
+     * directly, without materializing a temporary std::string per call.
+     */
+    struct string_hash
+    {
+        using is_transparent = void;
+
+        [[nodiscard]] std::size_t
+        operator()(const std::string_view key) const noexcept
+        {
+            return static_cast<std::size_t>(detail::hash_key(key));
+        }
+
+        // Same hash as for the key's text, without computing it again
+        [[nodiscard]] std::size_t
+        operator()(const hashed_key& key) const noexcept
+        {
+            return static_cast<std::size_t>(key.hash());
+        }
+    };
+
+    /**
+     * How an env matches variable names.
+     */
+    enum class key_case
+    {
+        // Names match byte for byte, like the POSIX environment
+        sensitive,
+        // ASCII letters match regardless of case, like the Windows
+        // environment; "Path" and "PATH" name the same variable
+        insensitive,
+    };
+
+    namespace detail
+    {
+        /**
+         * Transparent hasher for the names stored in an env, following its
+         * key_case. Case-sensitive hashes are the same as string_hash's.
+         */
+        struct key_hash
+        {
+            using is_transparent = void;
+
+            key_case policy = key_case::sensitive;
+
+            [[nodiscard]] std::size_t
+            operator()(const std::string_view key) const noexcept
+            {
+                return static_cast<std::size_t>(policy == key_case::sensitive
+                                                    ? hash_key(key)
+                                                    : hash_key_folded(key));
+            }
+
+            // The precomputed hash is case-sensitive; folding needs the name
+            [[nodiscard]] std::size_t
+            operator()(const hashed_key& key) const noexcept
+            {
+                return policy == key_case::sensitive
+                    ? static_cast<std::size_t>(key.hash())
+                    : (*this)(key.name());
+            }
+        };
+
+        /**
+         * Transparent equality for the names stored in an env, following its
+         * key_case.
+         */
+        struct key_equal
+        {
+            using is_transparent = void;
+
+            key_case policy = key_case::sensitive;
+
+            [[nodiscard]] bool operator()(const std::string_view a,
+                                          const std::string_view b) const noexcept
+            {
+                return policy == key_case::sensitive
+                    ? a == b
+                    : equals_case_insensitive(a, b);
+            }
+
+            [[nodiscard]] bool operator()(const hashed_key& a,
+                                          const std::string_view b) const noexcept
+            {
+                return (*this)(a.name(), b);
+            }
+
+            [[nodiscard]] bool operator()(const std::string_view a,
+                                          const hashed_key& b) const noexcept
+            {
+                return (*this)(a, b.name());
+            }
+        };
+    } // namespace detail
+
+    class concurrent_env;
+    class env_watcher;
+
+    /**
+     * When an env writes loaded variables into the process environment.
+     */
+    enum class injection_mode
+    {
+        // setenv/_putenv_s for every key as soon as it is parsed
+        eager,
+        // Only keep values in the env; export_to_process() installs them
+        deferred,
+    };
+
+    /**
+     * Whether, and when, ${NAME} and ${NAME:-default} references in loaded
+     * values are expanded.
+     */
+    enum class interpolation_mode
+    {
+        // Values are stored exactly as written
+        none,
+        // References are expanded once per load, after the whole file is read
+        eager,
+        // A value and what it references are expanded on its first lookup
+        lazy,
+    };
+
+    namespace detail
+    {
+        struct reload_state;
+        struct stream_window;
+    } // namespace detail
+
     class env
     {
     public:
         env() = default;
 
+        /**
+         * Creates an env whose loaded keys and values are allocated from the
+         * given memory resource.
+         *
+         * Passing a std::pmr::monotonic_buffer_resource keeps every map node
+         * and string of a loaded file packed together in a few large blocks,
+         * and makes teardown a single release of the arena:
+         *
+         *     std::pmr::monotonic_buffer_resource arena(1 << 20);
+         *     dot_env::env environment(&arena);
+         *
+         * The resource is not owned and must outlive this object. Copies of
+         * the object allocate from the default resource instead.
+         *
+         * @param resource The memory resource to allocate storage from.
+         */
+        explicit env(std::pmr::memory_resource* resource);
+
+        /**
+         * Creates an env that matches variable names as policy says.
+         *
+         * With key_case::insensitive, every lookup, load, reload and layer
+         * merge folds ASCII letters, e.g. get("Path") finds a loaded PATH,
+         * and a later "path=" assignment replaces it as a duplicate. A
+         * stored name keeps the spelling it was first assigned with. Names
+         * are hashed and compared eight bytes at a time without consulting
+         * the locale, so bytes outside ASCII must match exactly.
+         *
+         * The policy also applies to a captured system environment (on
+         * Windows, captured names are always matched case-insensitively, as
+         * getenv does there). Live getenv lookups and snapshots returned by
+         * freeze() still match names exactly.
+         *
+         * @param policy How names are matched.
+         * @param resource The memory resource to allocate storage from, see
+         * env(std::pmr::memory_resource*).
+         */
+        explicit env(key_case policy,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        [[nodiscard]] key_case case_policy() const noexcept
+        {
+            return env_vars_.key_eq().policy;
+        }
+
         /**
          * Loads environment variables from a specified file.
          *
-         * This function searches for the specified file in the current working
-         * directory. If the file is found, it reads and parses the environment
-         * variables contained within the file. The variables are stored
+         * This function opens the specified file relative to the current
+         * working directory; the directory itself is never listed. If the
+         * file is found, it reads and parses the environment variables
+         * contained within the file. The variables are stored
          * internally and injected into the system's environment variables.
          *
          * @param filename The name of the file to load environment variables
@@ -30,11 +234,352 @@ namespace dot_env
          * @param override_system If provided, overrides the compile-time
          * default. If not provided, uses the value set by
          * DOT_ENV_OVERRIDE_SYSTEM.
-         * @return Returns true if the file was successfully found and parsed,
-         *         otherwise returns false.
+         * @return The result, which converts to true if the file was
+         *         successfully found and parsed, and carries the diagnostics
+         *         collected while loading it.
+         */
+        load_result load_env(std::string_view filename = ".env",
+                             std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Loads environment variables from the nearest file with the given
+         * name, starting in the current working directory and walking up
+         * through its parents.
+         *
+         * The search stops after checking root (or the filesystem root if
+         * root is empty, or if the working directory is not below root).
+         * Each directory costs one stat of the candidate path. The resolved
+         * path is cached per working directory, file name and root for the
+         * lifetime of the process, so repeated loads, e.g. from several
+         * tools in a monorepo, skip the walk as long as the cached file
+         * still exists.
+         *
+         * @param filename The name of the file to look for. If not
+         * specified, defaults to ".env".
+         * @param root The last directory to check. If empty, the search may
+         * go up to the filesystem root.
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The result, which converts to true if a file was found and
+         * parsed, and carries the diagnostics collected while loading it.
+         */
+        load_result load_env_upwards(std::string_view filename = ".env",
+                              const std::filesystem::path& root = {},
+                              std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Loads several files as layers, e.g. .env, .env.local and
+         * .env.production, where each layer overrides the ones before it.
+         *
+         * The files are located relative to the current working directory
+         * like load_env(), and missing ones are skipped. Every file is read
+         * and tokenized on its own thread, then the layers are merged by
+         * precedence into one value per key before anything is stored. Each
+         * key is therefore stored, expanded and injected into the process
+         * environment once, with its final value, and keys overridden by a
+         * later layer are not reported as duplicates.
+         *
+         * reload_env() only tracks single files; after a layered load it
+         * returns std::nullopt until load_env() is called again.
+         *
+         * @param filenames The layers, lowest precedence first.
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The result, whose files member counts the layers that
+         * were found and parsed, with the diagnostics of all of them.
          */
-        bool load_env(std::string_view filename = ".env",
-                      std::optional<bool> override_system = std::nullopt);
+        load_result load_layers(std::span<const std::string_view> filenames,
+                                std::optional<bool> override_system = std::nullopt);
+
+        load_result load_layers(const std::initializer_list<std::string_view> filenames,
+                                const std::optional<bool> override_system = std::nullopt)
+        {
+            return load_layers(std::span(filenames.begin(), filenames.size()),
+                               override_system);
+        }
+
+        /**
+         * Loads environment variables from .env text held in memory, e.g.
+         * handed over by a secrets sidecar, without going through a file.
+         *
+         * The buffer is tokenized in place like a mapped file; only the
+         * stored keys and values are copied, so it may be released as soon
+         * as this returns. Diagnostics carry an empty file path. The buffer
+         * is not tracked by reload_env().
+         *
+         * @param content The .env text. Pass a std::string_view rather than
+         * a string literal, whose terminating '\0' would be part of the span.
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The result; files is 1.
+         */
+        load_result load_from_buffer(std::span<const char> content,
+                                     std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Loads environment variables from a stream, e.g. one end of a pipe.
+         *
+         * The stream is read in fixed-size windows and every window is
+         * tokenized up to its last complete line, so memory stays bounded
+         * by the window size or the longest line, not by the stream's
+         * length. Values may still reference keys from later windows.
+         *
+         * @param in The stream to read until its end.
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The result; files is 0 if reading failed, in which case
+         * the lines read before the failure have been loaded.
+         */
+        load_result load_from_stream(std::istream& in,
+                                     std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Loads environment variables from an open file descriptor.
+         *
+         * A regular file is memory-mapped and tokenized in place; pipes,
+         * sockets and other descriptors that cannot be mapped are streamed
+         * like load_from_stream(). Either way the descriptor is read from
+         * its current offset to its end, and left at the end but not
+         * closed.
+         *
+         * @param fd A readable file descriptor, owned by the caller.
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The result; files is 0 if reading failed.
+         */
+        load_result load_from_fd(int fd, std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Re-reads the file most recently loaded by load_env() and applies
+         * only what changed since it was last parsed.
+         *
+         * The previous parse is remembered as a list of content-defined
+         * chunks of lines, each with a hash and the keys it assigned. On
+         * reload only the chunks whose hash no longer matches are tokenized
+         * again; for the keys they touch, the winning value is recomputed
+         * and compared to the stored one. Stored values and the process
+         * environment are only updated for keys that really differ, so a
+         * one-line edit in a huge file costs one setenv call instead of one
+         * per key.
+         *
+         * Removed keys are erased, and unset in the process environment if
+         * it still holds the value this object loaded.
+         *
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return Returns the keys that were added, changed or removed, or
+         * std::nullopt if nothing has been loaded yet or the file can no
+         * longer be opened.
+         */
+        std::optional<env_diff>
+        reload_env(std::optional<bool> override_system = std::nullopt);
+
+        /**
+         * Selects when loaded variables reach the process environment.
+         *
+         * In the default eager mode every parsed key is passed to
+         * setenv/_putenv_s. On glibc each setenv may reallocate and copy the
+         * whole environ array under the environment lock, so loading N keys
+         * costs O(N^2). In deferred mode loads and reloads only fill this
+         * object, which get() and friends consult first anyway; call
+         * export_to_process() once if child processes need the variables.
+         *
+         * @param mode The mode used by subsequent loads and reloads.
+         */
+        void set_injection(const injection_mode mode) noexcept
+        {
+            injection_ = mode;
+        }
+
+        [[nodiscard]] injection_mode injection() const noexcept
+        {
+            return injection_;
+        }
+
+        /**
+         * Enables expansion of ${NAME} and ${NAME:-default} in loaded values.
+         *
+         * After a file is tokenized, the values that contain references form
+         * a dependency graph. Each of them is expanded exactly once, in
+         * topological order, so every reference sees its target already
+         * expanded and is a single lookup rather than a rescan of the text.
+         * A name that is not loaded resolves from the system environment,
+         * and a reference to an unset or empty variable expands to its
+         * default, or to nothing. A reference back to the value itself, or
+         * to another value on the same cycle, resolves from the system
+         * environment, so PATH=${PATH}:/opt extends the process's PATH.
+         * The system value is read once and reused by later loads and
+         * reloads, so a value injected into the process is not extended
+         * again. If the system environment does not have it either, it
+         * counts as unset and the value is reported as a cyclic_reference.
+         * Values referencing the cycle from outside see the results.
+         *
+         * In eager mode all of a file's values are expanded at the end of
+         * its load, against the variables known at that point. In lazy
+         * mode only the raw text is stored, and a value is expanded, along
+         * with everything it references, the first time it is read; values
+         * never read are never expanded. Since eager injection has to pass
+         * expanded values to the process, lazy expansion only defers work
+         * together with injection_mode::deferred. Reads of a lazily
+         * expanded value write to this object, so even const lookups must
+         * not run concurrently then.
+         *
+         * On reload, values that reference a changed variable are expanded
+         * again and reported as changed too (in lazy mode, only once they
+         * are expanded on their next read).
+         *
+         * @param mode The mode used by subsequent loads and reloads.
+         */
+        void set_interpolation(const interpolation_mode mode) noexcept
+        {
+            interpolation_ = mode;
+        }
+
+        [[nodiscard]] interpolation_mode interpolation() const noexcept
+        {
+            return interpolation_;
+        }
+
+        /**
+         * Sets how many threads tokenize a large file.
+         *
+         * With more than one thread, a file is cut at line boundaries into
+         * one slice per thread, with at least 1 MiB per slice, and the slices
+         * are tokenized concurrently. The results are then stored in file
+         * order, so a key assigned twice ends up with its last value exactly
+         * as in a serial parse. Knowing every token up front also lets the
+         * storage be sized once instead of growing and rehashing during the
+         * load. Files below 2 MiB are always parsed serially.
+         *
+         * @param threads The number of threads, 1 (the default) for serial
+         * parsing or 0 for one per hardware thread.
+         */
+        void set_parse_threads(const unsigned threads) noexcept
+        {
+            parse_threads_ = threads;
+        }
+
+        [[nodiscard]] unsigned parse_threads() const noexcept
+        {
+            return parse_threads_;
+        }
+
+        /**
+         * Lets loads use a binary cache compiled from the file.
+         *
+         * When enabled, loading FILE first tries FILE.bin, written by
+         * env_snapshot::save_cache() or the dot_env_cache tool. If the cache
+         * is valid and still matches FILE's size and modification time, its
+         * entries are stored directly, skipping the text parser entirely;
+         * otherwise FILE is parsed as usual. The cache is never written
+         * implicitly.
+         *
+         * reload_env() needs the chunk hashes of a text parse, so after a
+         * load served from the cache it returns std::nullopt.
+         *
+         * @param enabled Whether subsequent loads consult the cache.
+         */
+        void set_binary_cache(const bool enabled) noexcept
+        {
+            binary_cache_ = enabled;
+        }
+
+        [[nodiscard]] bool binary_cache() const noexcept
+        {
+            return binary_cache_;
+        }
+
+        /**
+         * Selects which diagnostics are produced and where they go.
+         *
+         * Diagnostics below min_level are dropped before anything about
+         * them is computed, so severity::off makes reporting free. Without
+         * a sink, the diagnostics of a load are collected into the
+         * load_result it returns; ones raised outside of a load, by
+         * reload_env() or a lazy expansion, are only seen by a sink. With a
+         * sink, every diagnostic is passed to it as it happens and nothing
+         * is collected. Nothing is ever written to stderr.
+         *
+         * By default warnings and errors are collected, and duplicate keys
+         * (severity::info) are not reported.
+         *
+         * @param min_level The lowest severity to report.
+         * @param sink Receives each diagnostic if set.
+         */
+        void set_diagnostics(const severity min_level, diagnostic_sink sink = {})
+        {
+            diagnostic_level_ = min_level;
+            diagnostic_sink_ = std::move(sink);
+        }
+
+        /**
+         * Copies the process environment into this object and resolves
+         * lookups that miss the loaded variables from that copy.
+         *
+         * Without a capture, every miss calls getenv, which takes the libc
+         * environment lock (and on Windows, _dupenv_s allocates). After it,
+         * misses are plain hash lookups in local storage, and typed values
+         * read from system variables are cached like loaded ones. The copy
+         * is taken from environ (GetEnvironmentStringsW on Windows) in one
+         * pass, and it is not updated when the process environment changes;
+         * call this again to refresh it.
+         *
+         * Variables with empty values are skipped, matching the live
+         * lookup. On Windows names are matched case-insensitively, as
+         * getenv does.
+         */
+        void capture_system_environment();
+
+        /**
+         * Drops the captured process environment and goes back to calling
+         * getenv on every miss.
+         */
+        void release_system_environment() noexcept;
+
+        [[nodiscard]] bool system_environment_captured() const noexcept
+        {
+            return system_captured_;
+        }
+
+        /**
+         * Installs all loaded variables into the process environment in a
+         * single pass.
+         *
+         * On POSIX systems a new environ array is built once, with existing
+         * entries kept or replaced in place and new ones appended, instead
+         * of calling setenv per key. The array and its strings are never
+         * freed, since other code may still hold pointers obtained from
+         * getenv; each export therefore retains roughly the size of the
+         * exported variables for the rest of the process. On Windows the
+         * variables are set one by one with _putenv_s.
+         *
+         * Like setenv, this must not race with other threads reading or
+         * modifying the environment.
+         *
+         * @param override_system If provided, overrides the compile-time
+         * default. If not provided, uses the value set by
+         * DOT_ENV_OVERRIDE_SYSTEM.
+         * @return The number of variables that were set.
+         */
+        std::size_t
+        export_to_process(std::optional<bool> override_system = std::nullopt) const;
+
+        /**
+         * Returns the path of the file most recently loaded by load_env().
+         *
+         * @return The resolved path, or an empty path if nothing has been
+         * loaded yet.
+         */
+        [[nodiscard]] const std::filesystem::path& loaded_path() const noexcept
+        {
+            return loaded_path_;
+        }
 
         /**
          * Retrieves the value of the specified environment variable.
@@ -49,6 +594,43 @@ namespace dot_env
          */
         std::optional<std::string> get(const std::string_view& key);
 
+        /**
+         * Retrieves a non-owning view of the specified environment
+         * variable's value.
+         *
+         * The lookup order is the same as get(), but no copy is made. The
+         * returned view points either into this object's internal storage or
+         * into the process environment block returned by getenv, and its
+         * lifetime is bound to that storage:
+         * - A view of a loaded variable stays valid until this object loads
+         *   or modifies variables again, or is destroyed.
+         * - A view of a system variable stays valid until that variable is
+         *   changed or removed in the process environment (setenv, putenv,
+         *   unsetenv, or a later load_env that injects it).
+         * Copy the value, or use get(), if it has to outlive either event.
+         *
+         * @param key The name of the environment variable to retrieve.
+         * @return Returns an optional containing a view of the value if
+         *         found; otherwise, returns std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string_view>
+        get_view(std::string_view key) const;
+
+        /**
+         * Retrieves a non-owning view of the specified environment
+         * variable's value, using a precomputed hash such as
+         * dot_env::key<"NAME"> for the loaded variables.
+         *
+         * Lookup order and view lifetimes are the same as for
+         * get_view(std::string_view).
+         *
+         * @param key The pre-hashed name of the environment variable.
+         * @return Returns an optional containing a view of the value if
+         *         found; otherwise, returns std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string_view>
+        get_view(const hashed_key& key) const;
+
         template <typename T>
             requires std::is_arithmetic_v<T>
         /**
@@ -110,15 +692,476 @@ namespace dot_env
          */
         std::optional<T> get_ne(const std::string_view& key);
 
+        template <class T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Same as get_le(const std::string_view&), but probes the loaded variables
+         * with the key's precomputed hash.
+         */
+        std::optional<T> get_le(const hashed_key& key)
+        {
+            return to_byte_order<std::endian::little>(lookup_parsed<T>(key));
+        }
+
+        template <class T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Same as get_be(const std::string_view&), but probes the loaded variables
+         * with the key's precomputed hash.
+         */
+        std::optional<T> get_be(const hashed_key& key)
+        {
+            return to_byte_order<std::endian::big>(lookup_parsed<T>(key));
+        }
+
+        template <class T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Same as get_ne(const std::string_view&), but probes the loaded variables
+         * with the key's precomputed hash.
+         */
+        std::optional<T> get_ne(const hashed_key& key)
+        {
+            return to_byte_order<std::endian::native>(lookup_parsed<T>(key));
+        }
+
+        template <class T>
+            requires parseable<T>
+        /**
+         * Retrieves the value of an environment variable parsed with
+         * parse_traits<T>, e.g. a bool, a std::chrono::duration, a
+         * byte_size or a list.
+         *
+         * The lookup order is the same as get(). Results for loaded
+         * variables are cached per entry, so repeated reads of the same type
+         * parse only once until the value changes. Types that borrow the
+         * text, such as std::string_view and list_view, follow the lifetime
+         * rules of get_view().
+         *
+         * @tparam T The type to parse the value as.
+         * @param key The name of the environment variable to retrieve.
+         * @return The parsed value if present and valid; otherwise
+         * std::nullopt.
+         */
+        std::optional<T> get_as(const std::string_view key)
+        {
+            return lookup_parsed<T>(key);
+        }
+
+        template <class T>
+            requires parseable<T>
+        std::optional<T> get_as(const hashed_key& key)
+        {
+            return lookup_parsed<T>(key);
+        }
+
         std::string require(std::string_view key);
 
+        /**
+         * Builds an immutable snapshot of the variables loaded so far.
+         *
+         * The snapshot copies the loaded keys and values into a flat,
+         * sorted layout that is cheaper to probe than the internal map and
+         * safe to read from any thread without locks. It is independent of
+         * this object: later loads do not affect it, and it stays valid after
+         * this object is destroyed. System environment variables are not
+         * included.
+         *
+         * @return The frozen snapshot of the loaded variables.
+         */
+        [[nodiscard]] env_snapshot freeze() const;
+
+        /**
+         * Reports how long loads took and how lookups were served.
+         *
+         * Every lookup through get(), get_view(), require() and the typed
+         * getters counts as a hit if a loaded variable answered it, as a
+         * fallback if the system environment did, and as a miss otherwise.
+         * Hits are counted on the entry itself, so the hot path stays a
+         * single relaxed atomic increment; fallbacks and misses are counted
+         * per name under a lock. Counting is safe from concurrent const
+         * lookups, so stats builds keep the same threading rules. The
+         * hottest keys are a good hint of what to freeze() into a snapshot
+         * or hoist out of a loop.
+         *
+         * Counting and timing only exist when the library is built with
+         * DOT_ENV_ENABLE_STATS; otherwise they are compiled out and this
+         * reports zeros.
+         *
+         * @param top How many of the most looked up keys to include.
+         * @return The counters accumulated since construction or the last
+         * reset_stats().
+         */
+        [[nodiscard]] env_stats stats(std::size_t top = 10) const;
+
+        /**
+         * Clears all load timings and lookup counters.
+         */
+        void reset_stats() noexcept;
+
 
     private:
-        void parse_env_file(const std::filesystem::path& path,
+        friend class concurrent_env;
+        friend class env_watcher;
+
+        /**
+         * A loaded value together with its most recent typed parse.
+         *
+         * The typed getters parse a value once per requested type and then
+         * serve repeated reads of the same type from the cached bits. Any
+         * assignment clears the cache, so a load or reload that changes the
+         * value is picked up on the next read.
+         *
+         * A value that references other variables also keeps its text as
+         * written in raw, and is pending until its expansion is stored in
+         * text.
+         */
+        struct stored_value
+        {
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            stored_value(const std::string_view value,
+                         const allocator_type& allocator) :
+                text(value, allocator), raw(allocator)
+            {
+            }
+
+            stored_value(const stored_value& other,
+                         const allocator_type& allocator) :
+                text(other.text, allocator), raw(other.raw, allocator),
+                pending(other.pending), cached_bits(other.cached_bits),
+                cached_type(other.cached_type), cached_valid(other.cached_valid)
+            {
+            }
+
+            stored_value(stored_value&& other,
+                         const allocator_type& allocator) :
+                text(std::move(other.text), allocator),
+                raw(std::move(other.raw), allocator), pending(other.pending),
+                cached_bits(other.cached_bits), cached_type(other.cached_type),
+                cached_valid(other.cached_valid)
+            {
+            }
+
+            void assign(const std::string_view value)
+            {
+                text.assign(value);
+                raw.clear();
+                pending = false;
+                cached_type = nullptr;
+            }
+
+            // The value as written in the file, before any expansion
+            [[nodiscard]] std::string_view source() const noexcept
+            {
+                return raw.empty() ? text : raw;
+            }
+
+            template <class T>
+            std::optional<T> parsed() const
+            {
+                if constexpr (!detail::cacheable_value<T>)
+                {
+                    return parse_traits<T>::parse(text);
+                }
+                else
+                {
+                    if (cached_type == detail::type_tag<T>())
+                    {
+                        if (!cached_valid)
+                            return std::nullopt;
+
+                        std::array<std::byte, sizeof(T)> bytes;
+                        std::memcpy(bytes.data(), &cached_bits, sizeof(T));
+                        return std::bit_cast<T>(bytes);
+                    }
+
+                    const auto value = parse_traits<T>::parse(text);
+                    cached_type = detail::type_tag<T>();
+                    cached_valid = value.has_value();
+                    if (value.has_value())
+                    {
+                        const auto bytes =
+                            std::bit_cast<std::array<std::byte, sizeof(T)>>(*value);
+                        std::memcpy(&cached_bits, bytes.data(), sizeof(T));
+                    }
+                    return value;
+                }
+            }
+
+            // Lazy interpolation stores the expansion on the first const read
+            mutable std::pmr::string text;
+            mutable std::pmr::string raw;
+            mutable bool pending = false;
+#ifdef DOT_ENV_ENABLE_STATS
+            // Lookups served by this value; copies start from zero. Const
+            // lookups may run on several threads, so it is atomic
+            mutable std::atomic<std::uint64_t> lookups = 0;
+#endif
+            // The cache does not change the value, so const lookups fill it
+            mutable std::uint64_t cached_bits = 0;
+            // detail::type_tag of the cached type; null when nothing is cached
+            mutable const void* cached_type = nullptr;
+            mutable bool cached_valid = false;
+        };
+
+        using storage = std::pmr::unordered_map<std::pmr::string, stored_value,
+                                                detail::key_hash, detail::key_equal>;
+
+        // An empty storage with the given policy
+        [[nodiscard]] static storage make_storage(key_case policy,
+                                                  std::pmr::memory_resource* resource)
+        {
+            return storage(0, detail::key_hash{policy}, detail::key_equal{policy},
+                           resource);
+        }
+
+        // Process environment lookup; empty values count as unset
+        static std::optional<std::string_view>
+        system_view(std::string_view key);
+
+        // Lookup in the captured copy of the process environment
+        [[nodiscard]] const stored_value*
+        find_captured(std::string_view key) const;
+
+        // Falls back to the captured or the live process environment
+        [[nodiscard]] std::optional<std::string_view>
+        system_fallback(std::string_view key) const;
+
+        // The system value a reference on a cycle resolves to; read once per
+        // name and kept for later loads and reloads
+        [[nodiscard]] std::optional<std::string_view>
+        inherited_value(std::string_view key) const;
+
+        // The out-of-line rest of get_view() once the loaded variables miss
+        [[nodiscard]] std::optional<std::string_view>
+        get_view_miss(std::string_view key) const;
+
+        // Lookup accounting for stats(); compiles to nothing without
+        // DOT_ENV_ENABLE_STATS
+        static void count_hit([[maybe_unused]] const stored_value& value) noexcept
+        {
+#ifdef DOT_ENV_ENABLE_STATS
+            value.lookups.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+
+        void count_fallback([[maybe_unused]] const std::string_view key,
+                            [[maybe_unused]] const bool found) const
+        {
+#ifdef DOT_ENV_ENABLE_STATS
+            fallback_stats_.count(key, found);
+#endif
+        }
+
+        // Adds a parse's size and duration to the stats while in scope
+        class parse_timer
+        {
+        public:
+#ifdef DOT_ENV_ENABLE_STATS
+            parse_timer(env& owner, const std::size_t bytes) noexcept :
+                owner_(owner), bytes_(bytes),
+                start_(std::chrono::steady_clock::now())
+            {
+            }
+
+            ~parse_timer()
+            {
+                ++owner_.loads_;
+                owner_.bytes_parsed_ += bytes_;
+                owner_.parse_time_ += std::chrono::steady_clock::now() - start_;
+            }
+
+            void add_bytes(const std::size_t bytes) noexcept { bytes_ += bytes; }
+
+        private:
+            env& owner_;
+            std::size_t bytes_;
+            std::chrono::steady_clock::time_point start_;
+#else
+            parse_timer(env&, std::size_t) noexcept {}
+            void add_bytes(std::size_t) noexcept {}
+#endif
+
+            parse_timer(const parse_timer&) = delete;
+            parse_timer& operator=(const parse_timer&) = delete;
+        };
+
+        template <class T, class Key>
+        std::optional<T> lookup_parsed(const Key& key);
+
+        // Flags a value for expansion if it references other variables
+        static void mark_references(stored_value& value);
+
+        // Expands the pending values reachable from roots, see
+        // set_interpolation()
+        void expand_pending(std::span<const std::string_view> roots) const;
+        void expand_all_pending() const;
+
+        // Runs a pending lazy expansion before a loaded value is read
+        const stored_value& settled(const storage::value_type& entry) const
+        {
+            if (entry.second.pending)
+            {
+                const std::string_view name = entry.first;
+                expand_pending({&name, 1});
+            }
+            return entry.second;
+        }
+
+        template <std::endian Order, class T>
+        static std::optional<T> to_byte_order(std::optional<T> value);
+
+        load_result load_path(std::filesystem::path path,
+                              std::optional<bool> override_system);
+        bool parse_env_file(const std::filesystem::path& path,
                             bool override_system);
 
+        // With a stream window, the buffer is one window of a longer
+        // input: lines are numbered on from the previous window and the
+        // parsed keys are left for the caller to finish_load()
+        void parse_env_buffer(std::string_view content, bool override_system,
+                              detail::reload_state* record = nullptr,
+                              const std::filesystem::path& file = {},
+                              detail::stream_window* stream = nullptr);
+
+        // Parses whatever read(char*, std::size_t) produces, a window at a
+        // time; read returns the bytes read, 0 at the end or -1 on errors
+        template <class Read>
+        load_result load_streamed(Read&& read, bool override_system);
+
+        // Passes a diagnostic to the sink or the current load's result;
+        // make() only runs if level is reported at all
+        template <class Make>
+        void report(const severity level, Make&& make) const
+        {
+            if (level < diagnostic_level_)
+                return;
 
-        std::unordered_map<std::string, std::string> env_vars_ = {};
+            diagnostic d = std::forward<Make>(make)();
+            d.level = level;
+            if (diagnostic_sink_)
+                diagnostic_sink_(d);
+            else if (collecting_)
+                collected_.push_back(std::move(d));
+        }
+
+        // Starts collecting diagnostics for a load
+        void begin_load() const noexcept
+        {
+            collected_.clear();
+            collecting_ = true;
+        }
+
+        [[nodiscard]] load_result end_load(const std::size_t files) const
+        {
+            collecting_ = false;
+            return {files, std::move(collected_)};
+        }
+
+        // Stores every entry of a cached snapshot as if it had been parsed
+        void load_snapshot(const env_snapshot& snapshot, bool override_system,
+                           const std::filesystem::path& file);
+
+        // Expands and injects freshly stored keys once a load has stored
+        // all of them
+        void finish_load(std::span<const std::string_view> keys,
+                         bool override_system);
+
+
+        storage env_vars_ = {};
+
+        // Copy of the process environment, see capture_system_environment()
+        storage system_vars_ = {};
+        bool system_captured_ = false;
+        // System values seen by references on a cycle, by variable, so a
+        // value injected into the process is not extended again on reload
+        mutable std::unordered_map<std::string, std::optional<std::string>, string_hash,
+                                   std::equal_to<>>
+            inherited_ = {};
+
+        std::filesystem::path loaded_path_ = {};
+        // Chunk hashes of loaded_path_ as last parsed, for reload_env()
+        std::shared_ptr<const detail::reload_state> reload_state_ = {};
+
+        injection_mode injection_ = injection_mode::eager;
+        interpolation_mode interpolation_ = interpolation_mode::none;
+        unsigned parse_threads_ = 1;
+        bool binary_cache_ = false;
+
+        severity diagnostic_level_ = severity::warning;
+        diagnostic_sink diagnostic_sink_ = {};
+        // Diagnostics of the load in progress, see set_diagnostics()
+        mutable std::vector<diagnostic> collected_ = {};
+        mutable bool collecting_ = false;
+
+#ifdef DOT_ENV_ENABLE_STATS
+        struct fallback_counts
+        {
+            std::uint64_t found = 0;
+            std::uint64_t missing = 0;
+        };
+
+        using fallback_map = std::unordered_map<std::string, fallback_counts,
+                                                string_hash, std::equal_to<>>;
+
+        /**
+         * Lookups that missed the loaded variables, by name. Const lookups
+         * may count from several threads, so the table has its own lock;
+         * copies take a copy of the counts and a lock of their own.
+         */
+        class fallback_table
+        {
+        public:
+            fallback_table() = default;
+
+            fallback_table(const fallback_table& other) :
+                counts_(other.copy())
+            {
+            }
+
+            fallback_table& operator=(const fallback_table& other)
+            {
+                if (this != &other)
+                {
+                    auto counts = other.copy();
+                    const std::scoped_lock lock(mutex_);
+                    counts_ = std::move(counts);
+                }
+                return *this;
+            }
+
+            void count(const std::string_view key, const bool found)
+            {
+                const std::scoped_lock lock(mutex_);
+                auto it = counts_.find(key);
+                if (it == counts_.end())
+                    it = counts_.emplace(std::string(key), fallback_counts{}).first;
+                ++(found ? it->second.found : it->second.missing);
+            }
+
+            [[nodiscard]] fallback_map copy() const
+            {
+                const std::scoped_lock lock(mutex_);
+                return counts_;
+            }
+
+            void clear()
+            {
+                const std::scoped_lock lock(mutex_);
+                counts_.clear();
+            }
+
+        private:
+            mutable std::mutex mutex_;
+            fallback_map counts_;
+        };
+
+        mutable fallback_table fallback_stats_ = {};
+        std::size_t loads_ = 0;
+        std::uint64_t bytes_parsed_ = 0;
+        std::chrono::nanoseconds parse_time_{0};
+#endif
     };
 
     template <typename T>
@@ -140,26 +1183,7 @@ namespace dot_env
      */
     std::optional<T> env::get_le(const std::string_view& key)
     {
-        const auto val = get(key);
-        if (!val.has_value())
-            return std::nullopt;
-
-        T value;
-        auto [ptr, ec] =
-            std::from_chars(val->data(), val->data() + val->size(), value);
-        if (ec != std::errc{})
-            return std::nullopt;
-
-        if constexpr (std::endian::native == std::endian::little)
-        {
-            // ReSharper disable once CppDFAUnreachableCode
-            return value;
-        }
-        else
-        {
-            // ReSharper disable once CppDFAUnreachableCode
-            return std::byteswap(value);
-        }
+        return to_byte_order<std::endian::little>(lookup_parsed<T>(key));
     }
 
     template <typename T>
@@ -181,26 +1205,7 @@ namespace dot_env
      */
     std::optional<T> env::get_be(const std::string_view& key)
     {
-        const auto val = get(key);
-        if (!val.has_value())
-            return std::nullopt;
-
-        T value;
-        auto [ptr, ec] =
-            std::from_chars(val->data(), val->data() + val->size(), value);
-        if (ec != std::errc{})
-            return std::nullopt;
-
-        if constexpr (std::endian::native == std::endian::big)
-        {
-            // ReSharper disable once CppDFAUnreachableCode
-            return value;
-        }
-        else
-        {
-            // ReSharper disable once CppDFAUnreachableCode
-            return std::byteswap(value);
-        }
+        return to_byte_order<std::endian::big>(lookup_parsed<T>(key));
     }
 
 
@@ -223,19 +1228,105 @@ namespace dot_env
      */
     std::optional<T> env::get_ne(const std::string_view& key)
     {
-        const auto val = get(key);
-        if (!val.has_value())
-            return std::nullopt;
+        return to_byte_order<std::endian::native>(lookup_parsed<T>(key));
+    }
+
+    template <class T, class Key>
+    /**
+     * Finds key and parses its value with parse_traits<T>. Loaded and
+     * captured system values go through their per-entry cache; live system
+     * values are parsed on every call since the process environment can
+     * change at any time.
+     */
+    std::optional<T> env::lookup_parsed(const Key& key)
+    {
+        if (const auto it = env_vars_.find(key); it != env_vars_.end())
+        {
+            count_hit(it->second);
+            return settled(*it).template parsed<T>();
+        }
+
+        std::string_view name;
+        if constexpr (std::is_same_v<Key, hashed_key>)
+            name = key.name();
+        else
+            name = key;
 
-        T value;
-        auto [ptr, ec] =
-            std::from_chars(val->data(), val->data() + val->size(), value);
-        if (ec != std::errc{})
+        if (system_captured_)
+        {
+            const stored_value* captured = find_captured(name);
+            count_fallback(name, captured != nullptr);
+            if (captured == nullptr)
+                return std::nullopt;
+
+            return captured->template parsed<T>();
+        }
+
+        const auto text = system_view(name);
+        count_fallback(name, text.has_value());
+        if (!text.has_value())
             return std::nullopt;
 
-        return value;
+        return parse_traits<T>::parse(*text);
+    }
+
+    // The getters below are defined inline so that a hit, a probe of the
+    // loaded variables, can be inlined into callers; misses and system
+    // lookups stay out of line
+    inline std::optional<std::string_view>
+    env::get_view(const std::string_view key) const
+    {
+        if (const auto it = env_vars_.find(key); it != env_vars_.end())
+        {
+            count_hit(it->second);
+            return std::string_view(settled(*it).text);
+        }
+
+        return get_view_miss(key);
     }
 
+    inline std::optional<std::string_view>
+    env::get_view(const hashed_key& key) const
+    {
+        if (const auto it = env_vars_.find(key); it != env_vars_.end())
+        {
+            count_hit(it->second);
+            return std::string_view(settled(*it).text);
+        }
+
+        return get_view_miss(key.name());
+    }
+
+    inline std::optional<std::string> env::get(const std::string_view& key)
+    {
+        if (const auto value = get_view(key))
+        {
+            return std::string(*value);
+        }
+
+        return std::nullopt;
+    }
+
+    template <std::endian Order, class T>
+    /**
+     * Converts a parsed value to the requested byte order.
+     */
+    std::optional<T> env::to_byte_order(const std::optional<T> value)
+    {
+        if (!value.has_value())
+            return std::nullopt;
+
+        if constexpr (Order == std::endian::native)
+        {
+            // ReSharper disable once CppDFAUnreachableCode
+            return value;
+        }
+        else
+        {
+            // ReSharper disable once CppDFAUnreachableCode
+            return std::byteswap(*value);
+        }
+    }
 } // namespace dot_env
 
 #endif // ENV_HPP
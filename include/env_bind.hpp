@@ -0,0 +1,224 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_BIND_HPP
+#define ENV_BIND_HPP
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "env_traits.hpp"
+
+namespace dot_env
+{
+    class env_snapshot;
+
+    /**
+     * Describes one member of a config struct and the variable it is read
+     * from.
+     *
+     * A member of type std::optional<T> is optional: a missing key leaves it
+     * empty. Any other member is required. The value type (T itself for
+     * optionals) is parsed with parse_traits, so it can be anything
+     * parseable, such as std::string, numbers, bool, durations or lists.
+     *
+     * Fields are usually collected into a constexpr table:
+     *
+     *     constexpr auto server_fields = std::tuple{
+     *         dot_env::field{"HOST", &server_config::host},
+     *         dot_env::field{"PORT", &server_config::port},
+     *         dot_env::field{"TIMEOUT_MS", &server_config::timeout_ms},
+     *     };
+     *
+     * @tparam Struct The config struct.
+     * @tparam Member The type of the bound member.
+     */
+    template <typename Struct, typename Member>
+    struct field
+    {
+        std::string_view key;
+        Member Struct::* member;
+    };
+
+    /**
+     * One key that could not be bound.
+     */
+    struct bind_issue
+    {
+        enum class kind
+        {
+            missing,
+            malformed,
+        };
+
+        std::string key;
+        kind problem;
+        // The offending value for malformed keys; empty for missing ones
+        std::string value;
+    };
+
+    /**
+     * Thrown by bind_config() with every key that could not be bound, rather than
+     * only the first one.
+     */
+    class bind_error : public std::runtime_error
+    {
+    public:
+        explicit bind_error(std::vector<bind_issue> issues) :
+            std::runtime_error(describe(issues)), issues_(std::move(issues))
+        {
+        }
+
+        [[nodiscard]] const std::vector<bind_issue>& issues() const noexcept
+        {
+            return issues_;
+        }
+
+    private:
+        static std::string describe(const std::vector<bind_issue>& issues)
+        {
+            std::string message = "Failed to bind environment variables:";
+            for (const auto& issue : issues)
+            {
+                message += issue.problem == bind_issue::kind::missing
+                    ? " missing "
+                    : " malformed ";
+                message += issue.key;
+                message += issue.problem == bind_issue::kind::missing
+                    ? ";"
+                    : " (\"" + issue.value + "\");";
+            }
+            message.pop_back();
+            return message;
+        }
+
+        std::vector<bind_issue> issues_;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        struct optional_member : std::false_type
+        {
+            using value_type = T;
+        };
+
+        template <typename T>
+        struct optional_member<std::optional<T>> : std::true_type
+        {
+            using value_type = T;
+        };
+
+        // Only a snapshot's text stays put for as long as the source lives;
+        // an env replaces its values on every load and reload
+        template <typename Source>
+        inline constexpr bool keeps_text_alive =
+            std::is_same_v<std::remove_cv_t<Source>, env_snapshot>;
+
+        template <typename Source, typename Struct, typename Member>
+        void bind_field(const Source& source, Struct& target,
+                        const field<Struct, Member>& f,
+                        std::vector<bind_issue>& issues)
+        {
+            using traits = optional_member<Member>;
+            using value_type = typename traits::value_type;
+            static_assert(parseable<value_type>,
+                          "bound members need a parse_traits specialization");
+            static_assert(keeps_text_alive<Source> || !borrows_text<value_type>,
+                          "members that borrow the text, such as std::string_view "
+                          "and list_view, can only be bound from an env_snapshot");
+
+            const std::optional<std::string_view> text = source.get_view(f.key);
+            if (!text.has_value())
+            {
+                if constexpr (traits::value)
+                    target.*f.member = std::nullopt;
+                else
+                    issues.push_back(
+                        {std::string(f.key), bind_issue::kind::missing, {}});
+                return;
+            }
+
+            auto value = parse_traits<value_type>::parse(*text);
+            if (!value.has_value())
+            {
+                issues.push_back({std::string(f.key),
+                                  bind_issue::kind::malformed,
+                                  std::string(*text)});
+                return;
+            }
+
+            target.*f.member = std::move(*value);
+        }
+    } // namespace detail
+
+    /**
+     * Fills the members of target described by fields from source, and
+     * collects every key that is missing or does not parse.
+     *
+     * Each key is probed once with get_view(), so nothing is copied except
+     * into std::string members, and no exception is thrown per key.
+     * Members whose keys failed keep their previous value.
+     *
+     * Source can be an env, an env_snapshot, or anything else with a
+     * get_view(std::string_view) returning std::optional<std::string_view>.
+     * To bind from a concurrent_env, pass *snapshot() so that every member
+     * is read from the same generation. Members whose type borrows the
+     * text (std::string_view, list_view) are only accepted from an
+     * env_snapshot, which keeps the text for as long as it lives; any other
+     * source may replace it on a reload.
+     *
+     * @param source Where to read the variables from.
+     * @param target The struct to fill.
+     * @param fields A tuple of field descriptors for Struct.
+     * @return Every key that could not be bound, in field order; empty on
+     * success.
+     */
+    template <typename Source, typename Struct, typename... Members>
+    std::vector<bind_issue>
+    bind_config_into(const Source& source, Struct& target,
+                     const std::tuple<field<Struct, Members>...>& fields)
+    {
+        std::vector<bind_issue> issues;
+        std::apply([&](const auto&... f)
+                   { (detail::bind_field(source, target, f, issues), ...); },
+                   fields);
+        return issues;
+    }
+
+    /**
+     * Creates a Struct and binds all of its described members from source.
+     *
+     * The name avoids plain bind: the field table is a std::tuple, so an
+     * unqualified call would also find std::bind through argument-dependent
+     * lookup.
+     *
+     * @param source Where to read the variables from.
+     * @param fields A tuple of field descriptors for Struct.
+     * @return The populated struct.
+     * @throws bind_error listing every missing or malformed key if any
+     * field could not be bound.
+     */
+    template <typename Struct, typename Source, typename... Members>
+        requires std::is_default_constructible_v<Struct>
+    [[nodiscard]] Struct
+    bind_config(const Source& source,
+                const std::tuple<field<Struct, Members>...>& fields)
+    {
+        Struct target{};
+        if (auto issues = bind_config_into(source, target, fields); !issues.empty())
+            throw bind_error(std::move(issues));
+
+        return target;
+    }
+} // namespace dot_env
+
+#endif // ENV_BIND_HPP
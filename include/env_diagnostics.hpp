@@ -0,0 +1,78 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_DIAGNOSTICS_HPP
+#define ENV_DIAGNOSTICS_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dot_env
+{
+    /**
+     * How serious a diagnostic is. Levels are ordered, so a minimum level
+     * selects everything at or above it; off selects nothing.
+     */
+    enum class severity
+    {
+        info,
+        warning,
+        error,
+        off,
+    };
+
+    /**
+     * One problem noticed while loading or expanding variables.
+     */
+    struct diagnostic
+    {
+        enum class kind
+        {
+            // A line with '=' but an empty key or value; it was skipped
+            invalid_line,
+            // A key assigned again in the same file; the later value wins
+            duplicate_key,
+            // A value on a ${NAME} reference cycle that the system environment
+            // could not resolve either; those references expanded as unset
+            cyclic_reference,
+            // The file was found but could not be opened or read
+            unreadable_file,
+        };
+
+        kind problem;
+        severity level;
+        std::filesystem::path file;
+        // 1-based position, or 0 when the problem has no position
+        std::size_t line = 0;
+        std::size_t column = 0;
+        // The offending line for invalid lines, otherwise the key
+        std::string text;
+    };
+
+    /**
+     * Receives diagnostics as they are produced, instead of collecting them.
+     */
+    using diagnostic_sink = std::function<void(const diagnostic&)>;
+
+    /**
+     * The outcome of a load: how many files were read, and the diagnostics
+     * collected along the way.
+     *
+     * Converts to true if at least one file was found and parsed, so it can
+     * be tested like the bool the loaders used to return.
+     */
+    struct load_result
+    {
+        std::size_t files = 0;
+        // Empty when a diagnostic_sink is installed; it received them instead
+        std::vector<diagnostic> diagnostics;
+
+        explicit operator bool() const noexcept { return files != 0; }
+    };
+} // namespace dot_env
+
+#endif // ENV_DIAGNOSTICS_HPP
@@ -0,0 +1,209 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_KEY_HPP
+#define ENV_KEY_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace dot_env
+{
+    namespace detail
+    {
+        // Reads count (at most eight) bytes of text from pos as a
+        // little-endian word, zero-padded
+        [[nodiscard]] constexpr std::uint64_t
+        load_word(const std::string_view text, const std::size_t pos,
+                  const std::size_t count) noexcept
+        {
+            if !consteval
+            {
+                if (count == 8)
+                {
+                    std::uint64_t word;
+                    std::memcpy(&word, text.data() + pos, sizeof(word));
+                    if constexpr (std::endian::native == std::endian::big)
+                        word = std::byteswap(word);
+                    return word;
+                }
+            }
+
+            std::uint64_t word = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                word |= static_cast<std::uint64_t>(
+                            static_cast<unsigned char>(text[pos + i]))
+                    << (8 * i);
+            }
+            return word;
+        }
+
+        /**
+         * Lower-cases the ASCII letters among the eight bytes of word in one
+         * go. Every other byte, including non-ASCII ones, is left as is.
+         */
+        [[nodiscard]] constexpr std::uint64_t
+        fold_word(const std::uint64_t word) noexcept
+        {
+            constexpr std::uint64_t ones = 0x0101010101010101ull;
+            const std::uint64_t low = word & (0x7F * ones);
+            // Sets the high bit of exactly the bytes in 'A'..'Z'; no byte
+            // can carry into the next one
+            const std::uint64_t upper = (low + (0x80 - 'A') * ones) &
+                ~(low + (0x80 - 'Z' - 1) * ones) & ~word & (0x80 * ones);
+            return word | (upper >> 2);
+        }
+
+        template <bool Fold>
+        [[nodiscard]] constexpr std::uint64_t
+        hash_words(const std::string_view key) noexcept
+        {
+            constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+            const auto mix = [](std::uint64_t x) constexpr noexcept
+            {
+                x *= multiplier;
+                return x ^ (x >> 32);
+            };
+            const auto load = [&](const std::size_t pos,
+                                  const std::size_t count) constexpr noexcept
+            {
+                const std::uint64_t word = load_word(key, pos, count);
+                return Fold ? fold_word(word) : word;
+            };
+
+            std::uint64_t hash =
+                0xCBF29CE484222325ull ^ (key.size() * multiplier);
+            std::size_t pos = 0;
+            for (; pos + 8 <= key.size(); pos += 8)
+                hash = mix(hash ^ load(pos, 8));
+
+            hash = mix(hash ^ load(pos, key.size() - pos));
+            return mix(hash);
+        }
+
+        /**
+         * Hashes a key eight bytes at a time.
+         *
+         * The result only depends on the key's bytes, never on the platform
+         * or standard library, so it can be stored alongside a snapshot and
+         * evaluated at compile time.
+         *
+         * @param key The key to hash.
+         * @return The 64-bit hash of key.
+         */
+        [[nodiscard]] constexpr std::uint64_t
+        hash_key(const std::string_view key) noexcept
+        {
+            return hash_words<false>(key);
+        }
+
+        /**
+         * Same as hash_key(), but ignores the case of ASCII letters, so keys
+         * that compare equal with equals_case_insensitive() hash alike.
+         */
+        [[nodiscard]] constexpr std::uint64_t
+        hash_key_folded(const std::string_view key) noexcept
+        {
+            return hash_words<true>(key);
+        }
+
+        /**
+         * Compares two keys, ignoring the case of ASCII letters, eight bytes
+         * at a time. Bytes outside ASCII must match exactly; no locale is
+         * consulted.
+         */
+        [[nodiscard]] constexpr bool
+        equals_case_insensitive(const std::string_view a,
+                                const std::string_view b) noexcept
+        {
+            if (a.size() != b.size())
+                return false;
+
+            std::size_t pos = 0;
+            for (; pos + 8 <= a.size(); pos += 8)
+            {
+                if (fold_word(load_word(a, pos, 8)) != fold_word(load_word(b, pos, 8)))
+                    return false;
+            }
+            return fold_word(load_word(a, pos, a.size() - pos)) ==
+                fold_word(load_word(b, pos, b.size() - pos));
+        }
+
+        /**
+         * A string literal usable as a template argument.
+         */
+        template <std::size_t N>
+        struct fixed_string
+        {
+            char value[N]{};
+
+            consteval fixed_string(const char (&text)[N])
+            {
+                std::copy_n(text, N, value);
+            }
+
+            [[nodiscard]] constexpr std::string_view view() const noexcept
+            {
+                return {value, N - 1};
+            }
+        };
+    } // namespace detail
+
+    /**
+     * A key together with its precomputed hash.
+     *
+     * Lookups through a hashed_key skip hashing entirely and go straight to
+     * probing. Keys known at compile time are best spelled with the key
+     * variable template, which hashes them during compilation:
+     *
+     *     auto port = environment.get_ne<int>(dot_env::key<"PORT">);
+     *
+     * Keys only known at run time can still be hashed once up front and
+     * reused for any number of lookups. A hashed_key does not own its name;
+     * the viewed characters must outlive it.
+     */
+    class hashed_key
+    {
+    public:
+        constexpr explicit hashed_key(const std::string_view name) noexcept :
+            name_(name), hash_(detail::hash_key(name))
+        {
+        }
+
+        [[nodiscard]] constexpr std::string_view name() const noexcept
+        {
+            return name_;
+        }
+
+        [[nodiscard]] constexpr std::uint64_t hash() const noexcept
+        {
+            return hash_;
+        }
+
+        friend constexpr bool operator==(const hashed_key& lhs,
+                                         const std::string_view rhs) noexcept
+        {
+            return lhs.name_ == rhs;
+        }
+
+    private:
+        std::string_view name_;
+        std::uint64_t hash_;
+    };
+
+    /**
+     * A hashed_key for a string literal, hashed at compile time.
+     *
+     * @tparam Name The key, e.g. dot_env::key<"DATABASE_URL">.
+     */
+    template <detail::fixed_string Name>
+    inline constexpr hashed_key key{Name.view()};
+} // namespace dot_env
+
+#endif // ENV_KEY_HPP
@@ -0,0 +1,46 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_PARSE_HPP
+#define ENV_PARSE_HPP
+
+#include <charconv>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace dot_env
+{
+    namespace detail
+    {
+        /**
+         * Parses text as an arithmetic value using std::from_chars.
+         *
+         * Parsing works directly on the supplied characters and never
+         * allocates. The whole of text does not need to be consumed; this
+         * mirrors the historical behavior of the typed getters.
+         *
+         * @tparam T The arithmetic type to parse.
+         * @param text The characters to parse.
+         * @return The parsed value, or std::nullopt if text does not start
+         * with a valid representation of T.
+         */
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        [[nodiscard]] std::optional<T>
+        parse_number(const std::string_view text) noexcept
+        {
+            T value;
+            auto [ptr, ec] =
+                std::from_chars(text.data(), text.data() + text.size(), value);
+            if (ec != std::errc{})
+                return std::nullopt;
+
+            return value;
+        }
+    } // namespace detail
+} // namespace dot_env
+
+#endif // ENV_PARSE_HPP
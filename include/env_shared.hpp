@@ -0,0 +1,182 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_SHARED_HPP
+#define ENV_SHARED_HPP
+
+#ifndef _WIN32
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "env_snapshot.hpp"
+
+namespace dot_env
+{
+    namespace detail
+    {
+        struct shared_control;
+    } // namespace detail
+
+    /**
+     * Publishes env_snapshots to shared memory, for processes that all
+     * need the same configuration, e.g. a supervisor and its workers.
+     *
+     * The supervisor parses once, freezes the result and publishes it; each
+     * worker maps a shared_snapshot read-only and serves lookups straight
+     * from the mapping, without parsing or copying anything. All workers
+     * share the same physical pages.
+     *
+     * A publisher owns a small control segment NAME holding the current
+     * generation, and one data segment NAME.GENERATION per snapshot, in the
+     * binary cache layout of env_snapshot::save_cache(). Segments are POSIX
+     * shared memory objects (shm_open). A publish writes a new data segment
+     * completely before bumping the generation, then unlinks the previous
+     * one; workers that still map it keep reading it undisturbed.
+     *
+     * A publisher is not thread-safe; call publish() from one thread.
+     */
+    class shared_snapshot_publisher
+    {
+    public:
+        shared_snapshot_publisher(const shared_snapshot_publisher&) = delete;
+        shared_snapshot_publisher& operator=(const shared_snapshot_publisher&) = delete;
+        shared_snapshot_publisher(shared_snapshot_publisher&& other) noexcept;
+        shared_snapshot_publisher& operator=(shared_snapshot_publisher&& other) noexcept;
+
+        /**
+         * Unlinks the control segment and the current data segment. Workers
+         * keep the snapshots they have mapped, but see no newer ones.
+         */
+        ~shared_snapshot_publisher();
+
+        /**
+         * Creates, or takes over, the control segment with the given name.
+         *
+         * Taking over a segment left behind by an earlier publisher
+         * continues its generation count, so workers still attached to it
+         * pick up the next publish.
+         *
+         * @param name The segment name, e.g. "/myapp_config"; a leading
+         * '/' is added if missing. It must not contain any other '/'.
+         * @param permissions Who may map the segments. Snapshots often hold
+         * secrets, so only the owner may by default; add group or others
+         * read permission for workers that run as a different user.
+         * @return The publisher, or std::nullopt if the segment could not
+         * be created or belongs to something else.
+         */
+        [[nodiscard]] static std::optional<shared_snapshot_publisher>
+        create(std::string_view name,
+               std::filesystem::perms permissions = std::filesystem::perms::owner_read |
+                   std::filesystem::perms::owner_write);
+
+        /**
+         * Copies snapshot into a new data segment and makes it the current
+         * generation.
+         *
+         * @param snapshot The variables to publish.
+         * @return Returns true if the snapshot was published, otherwise
+         * false; the previous generation then stays current.
+         */
+        bool publish(const env_snapshot& snapshot);
+
+        /**
+         * Returns the generation of the last publish, 0 if there was none.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept;
+
+        [[nodiscard]] const std::string& name() const noexcept
+        {
+            return name_;
+        }
+
+    private:
+        shared_snapshot_publisher(std::string name, detail::shared_control* control,
+                                  std::filesystem::perms permissions) noexcept;
+
+        std::string name_;
+        detail::shared_control* control_ = nullptr;
+        std::filesystem::perms permissions_ = std::filesystem::perms::none;
+    };
+
+    /**
+     * A worker's read-only view of the snapshots a shared_snapshot_publisher
+     * publishes.
+     *
+     * Checking for a newer generation is a single atomic load from the
+     * mapped control segment. Adopting it maps the new data segment and
+     * checks its structure once, in time linear in its size, but never
+     * parses text. Snapshots that were handed out stay valid, and keep
+     * their segment mapped, for as long as they or copies of them live.
+     *
+     * Like an env, a shared_snapshot must not be refreshed concurrently
+     * with other uses of the same object; each thread or worker can hold
+     * its own, or hand snapshot() to a concurrent_env.
+     */
+    class shared_snapshot
+    {
+    public:
+        /**
+         * Attaches to a publisher's control segment and maps its current
+         * snapshot.
+         *
+         * @param name The name given to shared_snapshot_publisher::create().
+         * @return The attached reader, or std::nullopt if no publisher
+         * created the segment. If nothing has been published yet, the
+         * snapshot is empty and refresh() picks up the first one.
+         */
+        [[nodiscard]] static std::optional<shared_snapshot>
+        open(std::string_view name);
+
+        /**
+         * Returns the snapshot of generation(); copies are cheap and share
+         * the mapping.
+         */
+        [[nodiscard]] const env_snapshot& snapshot() const noexcept
+        {
+            return snapshot_;
+        }
+
+        /**
+         * Returns the generation snapshot() belongs to, 0 for none.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept
+        {
+            return generation_;
+        }
+
+        /**
+         * Returns whether the publisher has published a newer generation
+         * than snapshot(). One atomic load; cheap enough to call per request.
+         */
+        [[nodiscard]] bool stale() const noexcept;
+
+        /**
+         * Adopts the newest published generation if it is newer than
+         * snapshot().
+         *
+         * @return Returns true if a newer snapshot was adopted, false if
+         * there is none or it could not be mapped; the current one then
+         * stays in place.
+         */
+        bool refresh();
+
+    private:
+        shared_snapshot(std::string name,
+                        std::shared_ptr<const detail::shared_control> control) noexcept;
+
+        std::string name_;
+        std::shared_ptr<const detail::shared_control> control_;
+        env_snapshot snapshot_ = {};
+        std::uint64_t generation_ = 0;
+    };
+} // namespace dot_env
+
+#endif // _WIN32
+
+#endif // ENV_SHARED_HPP
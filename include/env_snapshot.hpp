@@ -0,0 +1,524 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_SNAPSHOT_HPP
+#define ENV_SNAPSHOT_HPP
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "env_key.hpp"
+#include "env_parse.hpp"
+#include "env_traits.hpp"
+
+namespace dot_env
+{
+    /**
+     * Keys that differ between two snapshots, each list sorted by key.
+     */
+    struct env_diff
+    {
+        std::vector<std::string> added;
+        std::vector<std::string> changed;
+        std::vector<std::string> removed;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return added.empty() && changed.empty() && removed.empty();
+        }
+    };
+
+    namespace detail
+    {
+        // One variable of an env_snapshot: where its key and value sit in
+        // the string pool
+        struct snapshot_entry
+        {
+            std::uint32_t key_offset;
+            std::uint32_t key_length;
+            std::uint32_t value_offset;
+            std::uint32_t value_length;
+        };
+    } // namespace detail
+
+    /**
+     * Immutable, flat view of a set of loaded environment variables.
+     *
+     * A snapshot is built once (usually through env::freeze()) and never
+     * changes afterwards. Everything lives in one contiguous block: entries
+     * sorted by key, an open-addressing hash index over them and a string
+     * pool where each value directly follows its key. A lookup is a linear
+     * probe over a dense array of 64-bit slots, each holding part of the key
+     * hash, so a miss rarely touches the pool and a hit usually reads one
+     * slot, one entry and one pool region.
+     *
+     * All member functions are const and the storage is never written
+     * after construction, so a snapshot can be read from any number of
+     * threads concurrently without synchronization. Copies share the same
+     * storage and are cheap.
+     *
+     * Unlike env::get(), a snapshot only contains the variables it was
+     * built from; it never falls back to the process environment.
+     */
+    class env_snapshot
+    {
+    public:
+        env_snapshot() = default;
+
+        /**
+         * Builds a snapshot from key/value pairs.
+         *
+         * The pairs are copied into the snapshot's own storage. If a key
+         * appears more than once, the last occurrence wins.
+         *
+         * @param entries The variables to store.
+         * @return The frozen snapshot.
+         */
+        [[nodiscard]] static env_snapshot
+        from_entries(std::span<const std::pair<std::string_view,
+                                               std::string_view>> entries);
+
+        /**
+         * Retrieves a view of the value stored for key.
+         *
+         * The view stays valid for as long as this snapshot, or any copy of
+         * it, is alive.
+         *
+         * @param key The name of the variable to look up.
+         * @return A view of the value if present; otherwise std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string_view>
+        get_view(std::string_view key) const noexcept;
+
+        /**
+         * Retrieves a view of the value stored for a key whose hash is
+         * already known, e.g. dot_env::key<"NAME">, skipping the hashing
+         * step of get_view(std::string_view).
+         *
+         * @param key The pre-hashed name of the variable to look up.
+         * @return A view of the value if present; otherwise std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string_view>
+        get_view(const hashed_key& key) const noexcept;
+
+        /**
+         * Retrieves a copy of the value stored for key.
+         *
+         * @param key The name of the variable to look up.
+         * @return The value if present; otherwise std::nullopt.
+         */
+        [[nodiscard]] std::optional<std::string>
+        get(std::string_view key) const;
+
+        [[nodiscard]] std::optional<std::string>
+        get(const hashed_key& key) const;
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Retrieves the value stored for key parsed as an arithmetic type,
+         * in native-endian byte order.
+         *
+         * @tparam T The arithmetic type to parse the value as.
+         * @param key The name of the variable to look up.
+         * @return The parsed value if present and valid; otherwise
+         * std::nullopt.
+         */
+        [[nodiscard]] std::optional<T> get_ne(std::string_view key) const
+        {
+            const auto val = get_view(key);
+            if (!val.has_value())
+                return std::nullopt;
+
+            return detail::parse_number<T>(*val);
+        }
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        /**
+         * Same as get_ne(std::string_view), but probes with the key's
+         * precomputed hash.
+         */
+        [[nodiscard]] std::optional<T> get_ne(const hashed_key& key) const
+        {
+            const auto val = get_view(key);
+            if (!val.has_value())
+                return std::nullopt;
+
+            return detail::parse_number<T>(*val);
+        }
+
+        template <typename T>
+            requires parseable<T>
+        /**
+         * Retrieves the value stored for key parsed with parse_traits<T>.
+         * Borrowing types such as list_view stay valid as long as this
+         * snapshot.
+         *
+         * @tparam T The type to parse the value as.
+         * @param key The name of the variable to look up.
+         * @return The parsed value if present and valid; otherwise
+         * std::nullopt.
+         */
+        [[nodiscard]] std::optional<T> get_as(const std::string_view key) const
+        {
+            const auto val = get_view(key);
+            if (!val.has_value())
+                return std::nullopt;
+
+            return parse_traits<T>::parse(*val);
+        }
+
+        template <typename T>
+            requires parseable<T>
+        [[nodiscard]] std::optional<T> get_as(const hashed_key& key) const
+        {
+            const auto val = get_view(key);
+            if (!val.has_value())
+                return std::nullopt;
+
+            return parse_traits<T>::parse(*val);
+        }
+
+        [[nodiscard]] bool contains(const std::string_view key) const noexcept
+        {
+            return get_view(key).has_value();
+        }
+
+        [[nodiscard]] bool contains(const hashed_key& key) const noexcept
+        {
+            return get_view(key).has_value();
+        }
+
+        /**
+         * Random-access iterator over the variables of an env_snapshot.
+         *
+         * Dereferencing yields a pair of views by value, so it models
+         * std::random_access_iterator but is only a legacy input iterator.
+         */
+        class iterator
+        {
+        public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::pair<std::string_view, std::string_view>;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+
+            // Not defaulted: a defaulted constructor would not count until
+            // env_snapshot is complete, which subrange<iterator> needs below
+            iterator() noexcept : at_(nullptr), pool_(nullptr) {}
+
+            [[nodiscard]] value_type operator*() const noexcept
+            {
+                return {{pool_ + at_->key_offset, at_->key_length},
+                        {pool_ + at_->value_offset, at_->value_length}};
+            }
+
+            [[nodiscard]] value_type operator[](const difference_type n) const noexcept
+            {
+                return *(*this + n);
+            }
+
+            iterator& operator++() noexcept
+            {
+                ++at_;
+                return *this;
+            }
+
+            iterator operator++(int) noexcept
+            {
+                const iterator previous = *this;
+                ++at_;
+                return previous;
+            }
+
+            iterator& operator--() noexcept
+            {
+                --at_;
+                return *this;
+            }
+
+            iterator operator--(int) noexcept
+            {
+                const iterator previous = *this;
+                --at_;
+                return previous;
+            }
+
+            iterator& operator+=(const difference_type n) noexcept
+            {
+                at_ += n;
+                return *this;
+            }
+
+            iterator& operator-=(const difference_type n) noexcept
+            {
+                at_ -= n;
+                return *this;
+            }
+
+            [[nodiscard]] friend iterator operator+(iterator it,
+                                                    const difference_type n) noexcept
+            {
+                return it += n;
+            }
+
+            [[nodiscard]] friend iterator operator+(const difference_type n,
+                                                    iterator it) noexcept
+            {
+                return it += n;
+            }
+
+            [[nodiscard]] friend iterator operator-(iterator it,
+                                                    const difference_type n) noexcept
+            {
+                return it -= n;
+            }
+
+            [[nodiscard]] friend difference_type operator-(const iterator& lhs,
+                                                           const iterator& rhs) noexcept
+            {
+                return lhs.at_ - rhs.at_;
+            }
+
+            [[nodiscard]] friend bool operator==(const iterator& lhs,
+                                                 const iterator& rhs) noexcept
+            {
+                return lhs.at_ == rhs.at_;
+            }
+
+            [[nodiscard]] friend std::strong_ordering
+            operator<=>(const iterator& lhs, const iterator& rhs) noexcept
+            {
+                return lhs.at_ <=> rhs.at_;
+            }
+
+        private:
+            friend class env_snapshot;
+
+            iterator(const detail::snapshot_entry* at, const char* pool) noexcept :
+                at_(at), pool_(pool)
+            {
+            }
+
+            const detail::snapshot_entry* at_;
+            const char* pool_;
+        };
+
+        /**
+         * Iterates over all variables in key order. Each element is a pair
+         * of views of a key and its value, valid as long as this snapshot
+         * or a copy of it.
+         */
+        [[nodiscard]] iterator begin() const noexcept
+        {
+            return {entries_, pool_};
+        }
+
+        [[nodiscard]] iterator end() const noexcept
+        {
+            return {entries_ + count_, pool_};
+        }
+
+        /**
+         * Returns the variables whose names start with prefix, in key
+         * order, e.g. with_prefix("FEATURE_") for all feature flags.
+         *
+         * Entries are stored sorted by key, so the matches are one
+         * contiguous run found by two binary searches; only the matching
+         * entries and O(log n) others are read, and nothing is copied.
+         *
+         * @param prefix The common start of the names; an empty prefix
+         * matches every variable.
+         * @return The matching variables, as for begin() and end().
+         */
+        [[nodiscard]] std::ranges::subrange<iterator>
+        with_prefix(std::string_view prefix) const noexcept;
+
+        /**
+         * Computes which keys were added, changed or removed going from
+         * before to after.
+         *
+         * Both snapshots keep their entries sorted, so this is a single
+         * linear merge over the two entry arrays.
+         *
+         * @param before The older snapshot.
+         * @param after The newer snapshot.
+         * @return The keys that differ.
+         */
+        [[nodiscard]] static env_diff diff(const env_snapshot& before,
+                                           const env_snapshot& after);
+
+        /**
+         * Writes this snapshot to a binary cache file.
+         *
+         * The file holds a versioned header, then the snapshot's entries,
+         * hash index and string pool exactly as they are laid out in memory,
+         * so open_cache() can map it and serve lookups from the mapping
+         * without parsing or copying anything. The header records a
+         * checksum of that data and the size and modification time of
+         * source, which open_cache() uses to reject a cache that no longer
+         * matches its file. The cache is written next to its final name
+         * and renamed over it, so readers never see a partial file.
+         *
+         * The layout is native-endian and only meant to be read on the
+         * machine (or an identical platform) that wrote it.
+         *
+         * @param cache The file to write, conventionally the source path
+         * with ".bin" appended.
+         * @param source The text file this snapshot was parsed from.
+         * @return Returns true if the cache was written, otherwise false.
+         */
+        bool save_cache(const std::filesystem::path& cache,
+                        const std::filesystem::path& source) const;
+
+        /**
+         * Maps a binary cache written by save_cache().
+         *
+         * Validation costs one stat of source and one pass over the mapped
+         * data for the checksum; afterwards every lookup reads straight from
+         * the mapping, which stays alive as long as the snapshot or a copy
+         * of it. A cache from another version or platform, a corrupted one,
+         * or one whose source has changed size or modification time since
+         * is rejected, and the caller is expected to parse source instead.
+         *
+         * @param cache The cache file to map.
+         * @param source The text file the cache must have been built from.
+         * @return The cached snapshot, or std::nullopt if the cache is
+         * missing, invalid or stale.
+         */
+        [[nodiscard]] static std::optional<env_snapshot>
+        open_cache(const std::filesystem::path& cache,
+                   const std::filesystem::path& source);
+
+        [[nodiscard]] std::size_t size() const noexcept { return count_; }
+
+        [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+
+    private:
+        // Fills an env from a cache without going through the text parser
+        friend class env;
+        // Publish and map snapshots in the cache layout
+        friend class shared_snapshot;
+        friend class shared_snapshot_publisher;
+
+        using entry = detail::snapshot_entry;
+
+        // Size of the header that starts a cache image; the payload() follows
+        static constexpr std::size_t image_header_size = 64;
+
+        // Entries, hash index and pool, which are contiguous in that order
+        [[nodiscard]] std::string_view payload() const noexcept;
+
+        // Writes the header of this snapshot's cache image, recording the
+        // size and modification time of its source
+        void write_image_header(char* out, std::uint64_t source_size,
+                                std::int64_t source_mtime) const noexcept;
+
+        // Serves a snapshot from a cache image that owner keeps alive.
+        // Checks everything but the source stamp; the checksum only if
+        // verify_checksum is set.
+        [[nodiscard]] static std::optional<env_snapshot>
+        from_image(std::string_view image, std::shared_ptr<const void> owner,
+                   bool verify_checksum);
+
+        [[nodiscard]] std::string_view key_of(const entry& e) const noexcept
+        {
+            return {pool_ + e.key_offset, e.key_length};
+        }
+
+        [[nodiscard]] std::string_view value_of(const entry& e) const noexcept
+        {
+            return {pool_ + e.value_offset, e.value_length};
+        }
+
+        [[nodiscard]] const entry* find(std::string_view key,
+                                        std::uint64_t hash) const noexcept;
+
+        std::shared_ptr<const void> storage_ = {};
+        const entry* entries_ = nullptr;
+        // (hash >> 32) << 32 | (entry index + 1); zero marks an empty slot
+        const std::uint64_t* slots_ = nullptr;
+        std::uint64_t slot_mask_ = 0;
+        const char* pool_ = nullptr;
+        std::size_t count_ = 0;
+    };
+
+    // Lookups are defined inline so that callers can fold a constant hash
+    // into the probe; see env::get_view() for the same reasoning
+    inline const env_snapshot::entry*
+    env_snapshot::find(const std::string_view key,
+                       const std::uint64_t hash) const noexcept
+    {
+        if (count_ == 0)
+            return nullptr;
+
+        const std::uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+        for (std::uint64_t slot = hash & slot_mask_;;
+             slot = (slot + 1) & slot_mask_)
+        {
+            const std::uint64_t value = slots_[slot];
+            if (value == 0)
+                return nullptr;
+
+            if ((value & 0xFFFFFFFF00000000ull) == tag)
+            {
+                const entry& e = entries_[(value & 0xFFFFFFFFull) - 1];
+                if (key_of(e) == key)
+                    return &e;
+            }
+        }
+    }
+
+    inline std::optional<std::string_view>
+    env_snapshot::get_view(const std::string_view key) const noexcept
+    {
+        if (const entry* e = find(key, detail::hash_key(key)))
+            return value_of(*e);
+
+        return std::nullopt;
+    }
+
+    inline std::optional<std::string_view>
+    env_snapshot::get_view(const hashed_key& key) const noexcept
+    {
+        if (const entry* e = find(key.name(), key.hash()))
+            return value_of(*e);
+
+        return std::nullopt;
+    }
+
+    inline std::optional<std::string>
+    env_snapshot::get(const std::string_view key) const
+    {
+        if (const auto value = get_view(key))
+            return std::string(*value);
+
+        return std::nullopt;
+    }
+
+    inline std::optional<std::string>
+    env_snapshot::get(const hashed_key& key) const
+    {
+        if (const auto value = get_view(key))
+            return std::string(*value);
+
+        return std::nullopt;
+    }
+} // namespace dot_env
+
+#endif // ENV_SNAPSHOT_HPP
@@ -0,0 +1,90 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_STATS_HPP
+#define ENV_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dot_env
+{
+    /**
+     * Whether the library was built with DOT_ENV_ENABLE_STATS. Without it,
+     * nothing is counted or timed and env::stats() reports zeros.
+     */
+    inline constexpr bool stats_enabled =
+#ifdef DOT_ENV_ENABLE_STATS
+        true;
+#else
+        false;
+#endif
+
+    /**
+     * How often one key was looked up, and where the lookups were served.
+     */
+    struct key_stats
+    {
+        std::string key;
+        // Served from the loaded variables
+        std::uint64_t hits = 0;
+        // Not loaded, but found in the system environment
+        std::uint64_t fallbacks = 0;
+        // Found nowhere
+        std::uint64_t misses = 0;
+
+        [[nodiscard]] std::uint64_t lookups() const noexcept
+        {
+            return hits + fallbacks + misses;
+        }
+    };
+
+    /**
+     * Load timing and lookup counters of an env, see env::stats().
+     */
+    struct env_stats
+    {
+        // Files and buffers parsed, including reloads
+        std::size_t loads = 0;
+        std::uint64_t bytes_parsed = 0;
+        std::chrono::nanoseconds parse_time{0};
+        // Loaded variables right now
+        std::size_t entries = 0;
+
+        std::uint64_t hits = 0;
+        std::uint64_t fallbacks = 0;
+        std::uint64_t misses = 0;
+
+        // The most looked up keys, most frequent first
+        std::vector<key_stats> hottest;
+
+        [[nodiscard]] double bytes_per_second() const noexcept
+        {
+            return parse_time.count() == 0
+                ? 0.0
+                : static_cast<double>(bytes_parsed) * 1e9 /
+                    static_cast<double>(parse_time.count());
+        }
+
+        [[nodiscard]] double hit_rate() const noexcept
+        {
+            const std::uint64_t total = hits + fallbacks + misses;
+            return total == 0 ? 0.0
+                              : static_cast<double>(hits) / static_cast<double>(total);
+        }
+
+        [[nodiscard]] double fallback_rate() const noexcept
+        {
+            const std::uint64_t total = hits + fallbacks + misses;
+            return total == 0
+                ? 0.0
+                : static_cast<double>(fallbacks) / static_cast<double>(total);
+        }
+    };
+} // namespace dot_env
+
+#endif // ENV_STATS_HPP
@@ -0,0 +1,517 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_TRAITS_HPP
+#define ENV_TRAITS_HPP
+
+#include <charconv>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <ratio>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "env_parse.hpp"
+
+namespace dot_env
+{
+    /**
+     * Extension point for the get_as<T>() getters and dot_env::bind_config.
+     *
+     * A specialization provides
+     *
+     *     static std::optional<T> parse(std::string_view text) noexcept;
+     *
+     * returning std::nullopt for malformed text. Types whose parsed value
+     * keeps pointing into text (views, list_view) also declare
+     *
+     *     static constexpr bool borrows_text = true;
+     *
+     * so that getters which cannot keep the text alive refuse them.
+     *
+     * Built in are arithmetic types, bool, std::string, std::string_view,
+     * std::chrono::duration, byte_size, list_view and std::vector of any
+     * parseable type. Specialize it in namespace dot_env for your own
+     * types.
+     *
+     * @tparam T The type to parse.
+     */
+    template <typename T, typename = void>
+    struct parse_traits;
+
+    template <typename T>
+    concept parseable = requires(std::string_view text) {
+        { parse_traits<T>::parse(text) } -> std::same_as<std::optional<T>>;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        concept borrows_text_impl = requires {
+            requires parse_traits<T>::borrows_text;
+        };
+
+        [[nodiscard]] constexpr char fold_ascii(const char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        [[nodiscard]] constexpr bool
+        equals_ascii_ci(const std::string_view a,
+                        const std::string_view b) noexcept
+        {
+            if (a.size() != b.size())
+                return false;
+
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                if (fold_ascii(a[i]) != fold_ascii(b[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] constexpr std::string_view
+        trim_spaces(const std::string_view text) noexcept
+        {
+            std::size_t first = 0;
+            std::size_t last = text.size();
+            while (first < last && (text[first] == ' ' || text[first] == '\t'))
+                ++first;
+            while (last > first &&
+                   (text[last - 1] == ' ' || text[last - 1] == '\t'))
+                --last;
+
+            return text.substr(first, last - first);
+        }
+
+        /**
+         * Reads a leading unsigned integer from text and advances past it.
+         */
+        [[nodiscard]] inline std::optional<std::uint64_t>
+        consume_unsigned(std::string_view& text) noexcept
+        {
+            std::uint64_t value = 0;
+            const auto [ptr, ec] =
+                std::from_chars(text.data(), text.data() + text.size(), value);
+            if (ec != std::errc{})
+                return std::nullopt;
+
+            text.remove_prefix(static_cast<std::size_t>(ptr - text.data()));
+            return value;
+        }
+
+        [[nodiscard]] constexpr std::string_view
+        consume_letters(std::string_view& text) noexcept
+        {
+            std::size_t length = 0;
+            while (length < text.size() &&
+                   ((text[length] >= 'a' && text[length] <= 'z') ||
+                    (text[length] >= 'A' && text[length] <= 'Z')))
+            {
+                ++length;
+            }
+
+            const auto letters = text.substr(0, length);
+            text.remove_prefix(length);
+            return letters;
+        }
+    } // namespace detail
+
+    /**
+     * True for types whose parsed value views the text it was parsed from.
+     */
+    template <typename T>
+    concept borrows_text = detail::borrows_text_impl<T>;
+
+    namespace detail
+    {
+        template <typename T>
+        inline constexpr char type_anchor = 0;
+
+        /**
+         * A unique id for T, used to tag cached parse results.
+         */
+        template <typename T>
+        [[nodiscard]] constexpr const void* type_tag() noexcept
+        {
+            return &type_anchor<T>;
+        }
+
+        /**
+         * Parsed values small and plain enough to be cached as raw bits.
+         */
+        template <typename T>
+        concept cacheable_value = parseable<T> &&
+            std::is_trivially_copyable_v<T> &&
+            sizeof(T) <= sizeof(std::uint64_t) && !borrows_text_impl<T>;
+    } // namespace detail
+
+    /**
+     * A size in bytes, parsed from human-readable text such as "512MiB".
+     */
+    struct byte_size
+    {
+        std::uint64_t bytes = 0;
+
+        friend constexpr auto operator<=>(const byte_size&,
+                                          const byte_size&) = default;
+    };
+
+    template <char Separator = ','>
+    /**
+     * A lazily split, allocation-free list of items, e.g. "a, b, c".
+     *
+     * Iterating yields each item with surrounding spaces and tabs removed;
+     * empty items are skipped. The items are views into the original text,
+     * so the list must not outlive the value it was parsed from.
+     *
+     * @tparam Separator The character between items.
+     */
+    class basic_list_view
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view*;
+            using reference = std::string_view;
+
+            constexpr iterator() noexcept = default;
+
+            // A null data pointer in rest_ marks the end of the input
+            constexpr explicit iterator(const std::string_view rest) noexcept :
+                rest_(rest)
+            {
+                advance();
+            }
+
+            [[nodiscard]] constexpr std::string_view operator*() const noexcept
+            {
+                return item_;
+            }
+
+            constexpr iterator& operator++() noexcept
+            {
+                advance();
+                return *this;
+            }
+
+            constexpr iterator operator++(int) noexcept
+            {
+                auto copy = *this;
+                advance();
+                return copy;
+            }
+
+            [[nodiscard]] friend constexpr bool
+            operator==(const iterator& lhs, const iterator& rhs) noexcept
+            {
+                return lhs.done_ == rhs.done_ &&
+                    (lhs.done_ || lhs.item_.data() == rhs.item_.data());
+            }
+
+        private:
+            constexpr void advance() noexcept
+            {
+                while (rest_.data() != nullptr)
+                {
+                    const auto end = rest_.find(Separator);
+                    item_ = detail::trim_spaces(rest_.substr(0, end));
+                    rest_ = end == std::string_view::npos
+                        ? std::string_view{}
+                        : rest_.substr(end + 1);
+                    if (!item_.empty())
+                    {
+                        done_ = false;
+                        return;
+                    }
+                }
+                done_ = true;
+            }
+
+            std::string_view rest_ = {};
+            std::string_view item_ = {};
+            bool done_ = true;
+        };
+
+        constexpr basic_list_view() noexcept = default;
+
+        constexpr explicit basic_list_view(
+            const std::string_view text) noexcept : text_(text)
+        {
+        }
+
+        [[nodiscard]] constexpr iterator begin() const noexcept
+        {
+            return text_.empty() ? iterator{} : iterator(text_);
+        }
+
+        [[nodiscard]] constexpr iterator end() const noexcept { return {}; }
+
+        [[nodiscard]] constexpr bool empty() const noexcept
+        {
+            return begin() == end();
+        }
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept
+        {
+            return static_cast<std::size_t>(std::distance(begin(), end()));
+        }
+
+        [[nodiscard]] constexpr std::string_view text() const noexcept
+        {
+            return text_;
+        }
+
+    private:
+        std::string_view text_ = {};
+    };
+
+    using list_view = basic_list_view<','>;
+
+    template <typename T>
+    struct parse_traits<
+        T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+    {
+        [[nodiscard]] static std::optional<T>
+        parse(const std::string_view text) noexcept
+        {
+            return detail::parse_number<T>(text);
+        }
+    };
+
+    /**
+     * Accepts true/false, yes/no, on/off and 1/0 in any ASCII case.
+     */
+    template <>
+    struct parse_traits<bool>
+    {
+        [[nodiscard]] static std::optional<bool>
+        parse(const std::string_view text) noexcept
+        {
+            for (const std::string_view yes : {"true", "yes", "on", "1"})
+            {
+                if (detail::equals_ascii_ci(text, yes))
+                    return true;
+            }
+            for (const std::string_view no : {"false", "no", "off", "0"})
+            {
+                if (detail::equals_ascii_ci(text, no))
+                    return false;
+            }
+            return std::nullopt;
+        }
+    };
+
+    template <>
+    struct parse_traits<std::string>
+    {
+        [[nodiscard]] static std::optional<std::string>
+        parse(const std::string_view text)
+        {
+            return std::string(text);
+        }
+    };
+
+    template <>
+    struct parse_traits<std::string_view>
+    {
+        static constexpr bool borrows_text = true;
+
+        [[nodiscard]] static std::optional<std::string_view>
+        parse(const std::string_view text) noexcept
+        {
+            return text;
+        }
+    };
+
+    /**
+     * Accepts one or more <integer><unit> terms, e.g. "30s", "1h30m" or
+     * "250ms", with units ns, us, ms, s, m (or min), h and d. A bare
+     * integer is taken in the duration's own unit. Values that cannot be
+     * represented exactly by an integral Rep are rejected rather than
+     * truncated.
+     */
+    template <typename Rep, typename Period>
+    struct parse_traits<std::chrono::duration<Rep, Period>>
+    {
+        using duration = std::chrono::duration<Rep, Period>;
+
+        [[nodiscard]] static std::optional<duration>
+        parse(const std::string_view text) noexcept
+        {
+            std::string_view rest = detail::trim_spaces(text);
+            if (rest.empty())
+                return std::nullopt;
+
+            if (rest.find_first_not_of("0123456789") == std::string_view::npos)
+            {
+                const auto count = detail::parse_number<Rep>(rest);
+                if (!count.has_value())
+                    return std::nullopt;
+                return duration(*count);
+            }
+
+            using std::chrono::nanoseconds;
+            std::int64_t total = 0;
+            while (!rest.empty())
+            {
+                const auto count = detail::consume_unsigned(rest);
+                if (!count.has_value())
+                    return std::nullopt;
+
+                const auto unit = unit_nanoseconds(detail::consume_letters(rest));
+                if (unit == 0)
+                    return std::nullopt;
+
+                constexpr auto max = std::numeric_limits<std::int64_t>::max();
+                if (*count > static_cast<std::uint64_t>(max / unit))
+                    return std::nullopt;
+                const auto term = static_cast<std::int64_t>(*count) * unit;
+                if (total > max - term)
+                    return std::nullopt;
+                total += term;
+            }
+
+            const nanoseconds exact(total);
+            const auto converted = std::chrono::duration_cast<duration>(exact);
+            if constexpr (std::is_integral_v<Rep>)
+            {
+                if (std::chrono::duration_cast<nanoseconds>(converted) != exact)
+                    return std::nullopt;
+            }
+            return converted;
+        }
+
+    private:
+        [[nodiscard]] static constexpr std::int64_t
+        unit_nanoseconds(const std::string_view unit) noexcept
+        {
+            if (unit == "ns")
+                return 1;
+            if (unit == "us")
+                return 1'000;
+            if (unit == "ms")
+                return 1'000'000;
+            if (unit == "s")
+                return 1'000'000'000;
+            if (unit == "m" || unit == "min")
+                return 60 * 1'000'000'000ll;
+            if (unit == "h")
+                return 3'600 * 1'000'000'000ll;
+            if (unit == "d")
+                return 86'400 * 1'000'000'000ll;
+            return 0;
+        }
+    };
+
+    /**
+     * Accepts an integer followed by an optional unit, in any ASCII case
+     * and optionally separated by spaces: B; KB, MB, GB, TB as powers of
+     * 1000; KiB, MiB, GiB, TiB, or just K, M, G, T, as powers of 1024.
+     */
+    template <>
+    struct parse_traits<byte_size>
+    {
+        [[nodiscard]] static std::optional<byte_size>
+        parse(const std::string_view text) noexcept
+        {
+            std::string_view rest = detail::trim_spaces(text);
+            const auto count = detail::consume_unsigned(rest);
+            if (!count.has_value())
+                return std::nullopt;
+
+            rest = detail::trim_spaces(rest);
+            const auto unit = detail::consume_letters(rest);
+            if (!rest.empty())
+                return std::nullopt;
+
+            const auto multiplier = unit_bytes(unit);
+            if (multiplier == 0)
+                return std::nullopt;
+            if (*count > std::numeric_limits<std::uint64_t>::max() / multiplier)
+                return std::nullopt;
+
+            return byte_size{*count * multiplier};
+        }
+
+    private:
+        [[nodiscard]] static constexpr std::uint64_t
+        unit_bytes(const std::string_view unit) noexcept
+        {
+            constexpr std::string_view prefixes = "kmgt";
+            if (unit.empty() || detail::equals_ascii_ci(unit, "b"))
+                return 1;
+
+            const auto power = prefixes.find(detail::fold_ascii(unit.front()));
+            if (power == std::string_view::npos)
+                return 0;
+
+            const auto suffix = unit.substr(1);
+            std::uint64_t base;
+            if (suffix.empty() || detail::equals_ascii_ci(suffix, "ib"))
+                base = 1024;
+            else if (detail::equals_ascii_ci(suffix, "b"))
+                base = 1000;
+            else
+                return 0;
+
+            std::uint64_t result = base;
+            for (std::size_t i = 0; i < power; ++i)
+                result *= base;
+            return result;
+        }
+    };
+
+    template <char Separator>
+    struct parse_traits<basic_list_view<Separator>>
+    {
+        static constexpr bool borrows_text = true;
+
+        [[nodiscard]] static std::optional<basic_list_view<Separator>>
+        parse(const std::string_view text) noexcept
+        {
+            return basic_list_view<Separator>(text);
+        }
+    };
+
+    /**
+     * Splits on ',' like list_view and parses every item as T. Fails if
+     * any item fails.
+     */
+    template <typename T>
+        requires parseable<T>
+    struct parse_traits<std::vector<T>>
+    {
+        static constexpr bool borrows_text = detail::borrows_text_impl<T>;
+
+        [[nodiscard]] static std::optional<std::vector<T>>
+        parse(const std::string_view text)
+        {
+            std::vector<T> items;
+            for (const auto item : list_view(text))
+            {
+                auto value = parse_traits<T>::parse(item);
+                if (!value.has_value())
+                    return std::nullopt;
+                items.push_back(std::move(*value));
+            }
+            return items;
+        }
+    };
+} // namespace dot_env
+
+#endif // ENV_TRAITS_HPP
@@ -0,0 +1,218 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef ENV_WATCHER_HPP
+#define ENV_WATCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "concurrent_env.hpp"
+#include "env_snapshot.hpp"
+
+namespace dot_env
+{
+    /**
+     * Watches a .env file and hot-reloads a concurrent_env when it changes.
+     *
+     * The watcher listens for change notifications from the operating
+     * system (inotify on Linux, kqueue on macOS and the BSDs,
+     * ReadDirectoryChangesW on Windows) on the directory containing the
+     * file, so editors that save by writing a temporary file and renaming it
+     * over the original are handled too. Nothing is polled.
+     *
+     * On a notification the file is read and its contents hashed; if the
+     * hash matches the last read, the event is ignored. Otherwise the file
+     * is parsed into a new snapshot, published atomically to the target and
+     * diffed against the previous one. Subscribers are then invoked for the
+     * keys that actually changed. The first read happens as soon as the
+     * watcher starts, so an edit made after the target loaded the file but
+     * before start() is published too. If the notification queue overflows
+     * the file is re-read, since events may have been lost. If the directory
+     * itself is removed, the file is re-read once, and notifications may
+     * stop until the watcher is restarted.
+     *
+     * Callbacks run one at a time and in publish order, on the thread whose
+     * refresh() published the reload: the watcher's background thread for
+     * notifications. If another thread is already dispatching, that thread
+     * delivers the reload once its current callbacks return. Callbacks may
+     * call refresh(), on_change(), on_reload() and unsubscribe(); changes
+     * to the subscribers take effect from the next reload. They must not
+     * call stop() or destroy the watcher.
+     *
+     * A watcher reloads a single file. Targets whose snapshot was merged
+     * from several layers by concurrent_env::load_layers() are refused,
+     * since republishing one layer would drop the others.
+     */
+    class env_watcher
+    {
+    public:
+        /**
+         * Invoked for a key that was added, changed or removed.
+         *
+         * @param key The key that changed.
+         * @param value The new value, or std::nullopt if the key was
+         * removed. The view is valid for the duration of the call.
+         */
+        using key_callback = std::function<void(
+            std::string_view key, std::optional<std::string_view> value)>;
+
+        /**
+         * Invoked once per reload that changed anything.
+         *
+         * @param diff The keys that differ from the previous snapshot.
+         * @param current The snapshot that was just published.
+         */
+        using reload_callback = std::function<void(const env_diff& diff,
+                                                   const env_snapshot& current)>;
+
+        using subscription = std::size_t;
+
+        /**
+         * Creates a watcher for the file target last loaded.
+         *
+         * @param target The store to publish reloads to. Must outlive the
+         * watcher.
+         * @throws std::invalid_argument if target has not loaded a file.
+         */
+        explicit env_watcher(concurrent_env& target);
+
+        /**
+         * Creates a watcher for an explicit file.
+         *
+         * @param target The store to publish reloads to. Must outlive the
+         * watcher.
+         * @param path The file to watch.
+         */
+        env_watcher(concurrent_env& target, std::filesystem::path path);
+
+        env_watcher(const env_watcher&) = delete;
+        env_watcher& operator=(const env_watcher&) = delete;
+
+        /**
+         * Stops watching and joins the background thread.
+         */
+        ~env_watcher();
+
+        /**
+         * Starts the background thread. Does nothing if already running.
+         *
+         * @throws std::invalid_argument if the target's snapshot was merged
+         * from several layers.
+         * @throws std::system_error if the platform notification API could
+         * not be set up, or if this platform has none.
+         */
+        void start();
+
+        /**
+         * Stops the background thread and waits for it to exit. Does
+         * nothing if not running.
+         */
+        void stop();
+
+        /**
+         * Re-reads the file on the calling thread and publishes it if its
+         * contents changed since the last read, or if it was never read by
+         * this watcher. Notifications end up here as well; calling it
+         * directly is useful on platforms without a notification API.
+         * Nothing is published while the target holds several layers.
+         *
+         * No lock is held while callbacks run. A refresh() made from a
+         * callback publishes immediately and its callbacks run after the
+         * current ones return, before the outermost refresh() returns.
+         *
+         * @return Returns true if a new snapshot was published.
+         */
+        bool refresh();
+
+        /**
+         * Registers a callback for changes to one specific key.
+         *
+         * @param key The key to observe.
+         * @param callback Invoked after each reload that added, changed or
+         * removed the key.
+         * @return An id that can be passed to unsubscribe().
+         */
+        subscription on_change(std::string_view key, key_callback callback);
+
+        /**
+         * Registers a callback for every reload that changed anything.
+         *
+         * @param callback Invoked with the diff and the new snapshot.
+         * @return An id that can be passed to unsubscribe().
+         */
+        subscription on_reload(reload_callback callback);
+
+        /**
+         * Removes a callback registered with on_change() or on_reload().
+         * A reload that is already dispatching may still invoke it once.
+         *
+         * @param id The id returned on registration.
+         */
+        void unsubscribe(subscription id);
+
+        [[nodiscard]] const std::filesystem::path& path() const noexcept
+        {
+            return path_;
+        }
+
+    private:
+        struct native_watch;
+
+        struct key_subscriber
+        {
+            subscription id;
+            std::string key;
+            key_callback callback;
+        };
+
+        struct reload_subscriber
+        {
+            subscription id;
+            reload_callback callback;
+        };
+
+        struct pending_reload
+        {
+            env_diff diff;
+            env_snapshot current;
+        };
+
+        void run();
+
+        void dispatch_pending();
+
+        void notify(const env_diff& diff, const env_snapshot& current);
+
+        concurrent_env& target_;
+        std::filesystem::path path_;
+
+        // Serializes refresh() between the watcher thread and callers, and
+        // guards the queue of reloads still to be dispatched
+        std::mutex refresh_mutex_;
+        std::optional<std::uint64_t> content_hash_ = {};
+        std::deque<pending_reload> pending_ = {};
+        bool dispatching_ = false;
+
+        std::mutex subscribers_mutex_;
+        std::vector<key_subscriber> key_subscribers_ = {};
+        std::vector<reload_subscriber> reload_subscribers_ = {};
+        subscription next_id_ = 1;
+
+        std::unique_ptr<native_watch> native_;
+        std::thread thread_;
+    };
+} // namespace dot_env
+
+#endif // ENV_WATCHER_HPP
@@ -0,0 +1,131 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "../include/concurrent_env.hpp"
+
+#include "../include/env.hpp"
+
+#include <string>
+#include <vector>
+
+namespace dot_env
+{
+    namespace
+    {
+        // The working directory may change before an async task runs
+        [[nodiscard]] std::string resolve_now(const std::string_view filename)
+        {
+            if (filename.empty())
+                return {};
+
+            return (std::filesystem::current_path() / filename).string();
+        }
+    } // namespace
+
+    concurrent_env::concurrent_env() :
+        current_(std::make_shared<const env_snapshot>())
+    {
+    }
+
+    concurrent_env::concurrent_env(env_snapshot initial) :
+        current_(std::make_shared<const env_snapshot>(std::move(initial)))
+    {
+    }
+
+    bool concurrent_env::load_env(const std::string_view filename)
+    {
+        const std::scoped_lock lock(reload_mutex_);
+
+        // A fresh binary cache is published as is, served from its mapping
+        if (binary_cache() && !filename.empty())
+        {
+            auto path = std::filesystem::current_path() / filename;
+            auto cache_path = path;
+            cache_path += ".bin";
+            if (auto cached = env_snapshot::open_cache(cache_path, path))
+            {
+                current_.store(
+                    std::make_shared<const env_snapshot>(std::move(*cached)),
+                    std::memory_order_release);
+                source_path_ = std::move(path);
+                source_layers_ = 1;
+                return true;
+            }
+        }
+
+        env loader;
+        loader.set_injection(injection_mode::deferred);
+        if (!loader.load_env(filename, false))
+            return false;
+
+        current_.store(std::make_shared<const env_snapshot>(loader.freeze()),
+                       std::memory_order_release);
+        source_path_ = loader.loaded_path();
+        source_layers_ = 1;
+        return true;
+    }
+
+    std::size_t
+    concurrent_env::load_layers(const std::span<const std::string_view> filenames)
+    {
+        const std::scoped_lock lock(reload_mutex_);
+
+        env loader;
+        loader.set_injection(injection_mode::deferred);
+        const std::size_t loaded = loader.load_layers(filenames, false).files;
+        if (loaded == 0)
+            return 0;
+
+        current_.store(std::make_shared<const env_snapshot>(loader.freeze()),
+                       std::memory_order_release);
+        source_path_ = loader.loaded_path();
+        source_layers_ = loaded;
+        return loaded;
+    }
+
+    std::future<bool> concurrent_env::load_env_async(const std::string_view filename)
+    {
+        return std::async(std::launch::async,
+                          [this, path = resolve_now(filename)]
+                          { return load_env(path); });
+    }
+
+    std::future<std::size_t>
+    concurrent_env::load_layers_async(const std::span<const std::string_view> filenames)
+    {
+        std::vector<std::string> paths;
+        paths.reserve(filenames.size());
+        for (const auto filename : filenames)
+            paths.push_back(resolve_now(filename));
+
+        return std::async(std::launch::async,
+                          [this, paths = std::move(paths)]
+                          {
+                              const std::vector<std::string_view> views(
+                                  paths.begin(), paths.end());
+                              return load_layers(views);
+                          });
+    }
+
+    std::filesystem::path concurrent_env::source_path() const
+    {
+        const std::scoped_lock lock(reload_mutex_);
+        return source_path_;
+    }
+
+    std::size_t concurrent_env::source_layers() const
+    {
+        const std::scoped_lock lock(reload_mutex_);
+        return source_layers_;
+    }
+
+    std::shared_ptr<const env_snapshot>
+    concurrent_env::publish(env_snapshot snapshot)
+    {
+        const std::scoped_lock lock(reload_mutex_);
+        return current_.exchange(
+            std::make_shared<const env_snapshot>(std::move(snapshot)),
+            std::memory_order_acq_rel);
+    }
+} // namespace dot_env
@@ -4,184 +4,1658 @@
 
 #include "../include/env.hpp"
 
+#include "file_buffer.hpp"
+#include "interpolate.hpp"
+#include "parser.hpp"
+#include "reload_state.hpp"
+
 #include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <istream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <climits>
+#include <cwchar>
+#include <io.h>
+#elif defined(__APPLE__)
+#include <crt_externs.h>
+#else
+extern char** environ;
+#endif
+
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#endif
 
 namespace dot_env
 {
-    [[nodiscard]] inline bool equals_case_insensitive(const std::string_view a,
-                                                      const std::string_view b)
+    namespace detail
     {
-        if (a.length() != b.length())
+        /**
+         * State carried from one window of a streamed load to the next.
+         */
+        struct stream_window
         {
-            return false;
-        }
-
-        return std::ranges::equal(
-            std::begin(a), std::end(a), std::begin(b), std::end(b),
-            [](const uint8_t lhs, const uint8_t rhs)
-            { return std::tolower(lhs) == std::tolower(rhs); });
-    }
+            std::size_t first_line = 1;
+            std::vector<std::string_view> parsed_keys;
+            // Set for the final window, which holds the rest of the input
+            bool last = false;
+            // How much of the last window was tokenized
+            std::size_t consumed = 0;
+        };
+    } // namespace detail
 
-    bool env::load_env(const std::string_view filename,
-                       const std::optional<bool> override_system)
+    namespace
     {
-        // Use the compile-time default if no runtime override is provided
-        const bool should_override = override_system.value_or(
+        // Uses the compile-time default if no runtime override is provided
+        [[nodiscard]] bool
+        resolve_override(const std::optional<bool> override_system) noexcept
+        {
+            return override_system.value_or(
 #ifdef DOT_ENV_OVERRIDE_SYSTEM
-            true
+                true
 #else
-            false
+                false
 #endif
-        );
+            );
+        }
+
+        /**
+         * Invokes fn with a null-terminated copy of str.
+         *
+         * The C environment APIs need a terminated string, while string_view
+         * keys are not guaranteed to be terminated. Short keys are copied
+         * into a stack buffer so the common case avoids a heap allocation;
+         * only unusually long keys fall back to a temporary std::string.
+         */
+        template <typename Fn>
+        decltype(auto) with_c_str(const std::string_view str, Fn&& fn)
+        {
+            constexpr std::size_t stack_capacity = 256;
+            if (str.size() < stack_capacity)
+            {
+                std::array<char, stack_capacity> buffer;
+                std::ranges::copy(str, buffer.begin());
+                buffer[str.size()] = '\0';
+                return std::forward<Fn>(fn)(buffer.data());
+            }
+
+            const std::string owned(str);
+            return std::forward<Fn>(fn)(owned.c_str());
+        }
 
-        const auto current_path = std::filesystem::current_path();
-        std::filesystem::path env_path;
-        for (const auto& entry :
-             std::filesystem::directory_iterator(current_path))
+        /**
+         * Publishes one loaded variable to the process environment, leaving
+         * any existing non-empty value alone unless override_system is set.
+         */
+        void inject_into_process(const std::pmr::string& key,
+                                 const std::pmr::string& value,
+                                 const bool override_system)
         {
-            if (entry.is_regular_file())
+            // Check existing system environment variable
+#ifdef _WIN32
+            char* existing_env = nullptr;
+            size_t size;
+            _dupenv_s(&existing_env, &size, key.c_str());
+#else
+            const char* existing_env = std::getenv(key.c_str());
+#endif
+
+            // Decide whether to set the system environment variable
+            const bool should_set = override_system || !existing_env ||
+                *existing_env == '\0';
+
+            if (should_set)
+            {
+#ifdef _WIN32
+                _putenv_s(key.c_str(), value.c_str());
+#else
+                setenv(key.c_str(), value.c_str(), 1);
+#endif
+            }
+
+#ifdef _WIN32
+            if (existing_env)
+                free(existing_env);
+#endif
+        }
+
+        /**
+         * Removes a variable this env injected from the process
+         * environment, unless something else has replaced its value since.
+         */
+        void remove_from_process(const std::pmr::string& key,
+                                 const std::pmr::string& value)
+        {
+#ifdef _WIN32
+            char* existing_env = nullptr;
+            size_t size;
+            _dupenv_s(&existing_env, &size, key.c_str());
+            if (existing_env && value == existing_env)
+                _putenv_s(key.c_str(), "");
+            if (existing_env)
+                free(existing_env);
+#else
+            const char* existing_env = std::getenv(key.c_str());
+            if (existing_env && value == existing_env)
+                unsetenv(key.c_str());
+#endif
+        }
+
+
+        /**
+         * Picks the number of slices for tokenizing a buffer of the given
+         * size; slices below 1 MiB are not worth a thread.
+         */
+        [[nodiscard]] std::size_t parse_slices(unsigned threads,
+                                               const std::size_t bytes) noexcept
+        {
+            constexpr std::size_t min_slice_bytes = std::size_t{1} << 20;
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+
+            return std::min<std::size_t>(threads,
+                                         std::max<std::size_t>(1, bytes / min_slice_bytes));
+        }
+
+        /**
+         * Turns positions in a buffer into 1-based line and column numbers.
+         * Diagnostics are raised in buffer order, so each query only scans
+         * forward from the previous one, and nothing is scanned at all
+         * unless something is reported.
+         */
+        class line_locator
+        {
+        public:
+            explicit line_locator(const std::string_view buffer,
+                                  const std::size_t first_line = 1) noexcept :
+                buffer_(buffer), first_line_(first_line), line_(first_line)
+            {
+            }
+
+            [[nodiscard]] std::pair<std::size_t, std::size_t>
+            locate(const char* at) noexcept
             {
-                if (!filename.empty() && entry.path().filename() == filename)
+                const auto offset = static_cast<std::size_t>(at - buffer_.data());
+                if (offset < pos_)
                 {
-                    env_path = entry.path();
-                    break;
+                    pos_ = 0;
+                    line_ = first_line_;
+                    line_start_ = 0;
+                }
+                while (pos_ < offset)
+                {
+                    const auto* newline = static_cast<const char*>(
+                        std::memchr(buffer_.data() + pos_, '\n', offset - pos_));
+                    if (newline == nullptr)
+                    {
+                        pos_ = offset;
+                        break;
+                    }
+                    pos_ = static_cast<std::size_t>(newline - buffer_.data()) + 1;
+                    line_start_ = pos_;
+                    ++line_;
                 }
+                return {line_, offset - line_start_ + 1};
             }
+
+        private:
+            std::string_view buffer_;
+            std::size_t first_line_;
+            std::size_t pos_ = 0;
+            std::size_t line_;
+            std::size_t line_start_ = 0;
+        };
+
+        // Where an invalid line goes wrong: its '=' if the key is empty,
+        // otherwise just past it, where the value is missing
+        [[nodiscard]] const char* invalid_line_position(const std::string_view line) noexcept
+        {
+            const auto eq = line.find('=');
+            if (eq == std::string_view::npos || eq == 0)
+                return line.data();
+            return line.data() + eq + 1;
         }
 
-        if (env_path.empty())
+#ifndef _WIN32
+        char**& process_environ() noexcept
         {
-            return false;
+#ifdef __APPLE__
+            return *_NSGetEnviron();
+#else
+            return environ;
+#endif
         }
+#endif
+    } // namespace
 
-        parse_env_file(env_path, should_override);
-        return true;
+    env::env(std::pmr::memory_resource* resource) :
+        env(key_case::sensitive, resource)
+    {
     }
 
+    env::env(const key_case policy, std::pmr::memory_resource* resource) :
+        env_vars_(make_storage(policy, resource)),
+        system_vars_(make_storage(policy, resource))
+    {
+    }
+
+    load_result env::load_env(const std::string_view filename,
+                              const std::optional<bool> override_system)
+    {
+        if (filename.empty())
+        {
+            return {};
+        }
+
+        // Open the path directly: listing the directory would cost one
+        // stat per entry, which adds up on large or networked directories
+        auto env_path = std::filesystem::current_path() / filename;
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(env_path, error))
+        {
+            return {};
+        }
+
+        return load_path(std::move(env_path), override_system);
+    }
 
-    std::optional<std::string> env::get(const std::string_view& key)
+    load_result env::load_env_upwards(const std::string_view filename,
+                                      const std::filesystem::path& root,
+                                      const std::optional<bool> override_system)
     {
-        if (const auto it = env_vars_.find(std::string(key));
-            it != env_vars_.end())
+        if (filename.empty())
+        {
+            return {};
+        }
+
+        auto start = std::filesystem::current_path();
+        auto stop = root.empty()
+            ? std::filesystem::path{}
+            : std::filesystem::absolute(root).lexically_normal();
+        if (!stop.has_filename() && stop.has_relative_path())
+        {
+            // Drop a trailing separator so it compares equal to parent_path()
+            stop = stop.parent_path();
+        }
+
+        std::string cache_key = start.string();
+        cache_key.push_back('\0');
+        cache_key.append(filename);
+        cache_key.push_back('\0');
+        cache_key.append(stop.string());
+
+        static std::mutex cache_mutex;
+        static std::unordered_map<std::string, std::filesystem::path> cache;
+
+        std::error_code error;
+        std::filesystem::path cached;
         {
-            return it->second;
+            const std::scoped_lock lock(cache_mutex);
+            if (const auto it = cache.find(cache_key); it != cache.end())
+                cached = it->second;
+        }
+
+        // A stale entry just falls through to a fresh walk, which replaces it
+        if (!cached.empty() && std::filesystem::is_regular_file(cached, error))
+        {
+            return load_path(std::move(cached), override_system);
+        }
+
+        for (auto directory = std::move(start);;)
+        {
+            auto candidate = directory / filename;
+            if (std::filesystem::is_regular_file(candidate, error))
+            {
+                {
+                    const std::scoped_lock lock(cache_mutex);
+                    cache.insert_or_assign(std::move(cache_key), candidate);
+                }
+                return load_path(std::move(candidate), override_system);
+            }
+
+            auto parent = directory.parent_path();
+            if (directory == stop || parent == directory)
+            {
+                return {};
+            }
+            directory = std::move(parent);
+        }
+    }
+
+    load_result env::load_path(std::filesystem::path path,
+                               const std::optional<bool> override_system)
+    {
+        const bool should_override = resolve_override(override_system);
+        begin_load();
+
+        if (binary_cache_)
+        {
+            auto cache_path = path;
+            cache_path += ".bin";
+            if (const auto cached = env_snapshot::open_cache(cache_path, path))
+            {
+                load_snapshot(*cached, should_override, path);
+                reload_state_.reset();
+                loaded_path_ = std::move(path);
+                return end_load(1);
+            }
+        }
+
+        const bool parsed = parse_env_file(path, should_override);
+        loaded_path_ = std::move(path);
+        return end_load(parsed ? 1 : 0);
+    }
+
+    void env::load_snapshot(const env_snapshot& snapshot,
+                            const bool override_system,
+                            const std::filesystem::path& file)
+    {
+        const bool interpolate = interpolation_ != interpolation_mode::none;
+        std::vector<std::string_view> stored_keys;
+        stored_keys.reserve(interpolate ? snapshot.count_ : 0);
+        env_vars_.reserve(env_vars_.size() + snapshot.count_);
+
+        for (std::size_t i = 0; i < snapshot.count_; ++i)
+        {
+            const auto& e = snapshot.entries_[i];
+            const auto key = snapshot.key_of(e);
+            const auto value = snapshot.value_of(e);
+
+            auto it = env_vars_.find(key);
+            if (it == env_vars_.end())
+            {
+                it = env_vars_.emplace(key, value).first;
+            }
+            else
+            {
+                report(severity::info, [&]
+                       {
+                           return diagnostic{diagnostic::kind::duplicate_key,
+                                             severity::info, file, 0, 0,
+                                             std::string(key)};
+                       });
+                it->second.assign(value);
+            }
+
+            if (interpolate)
+            {
+                mark_references(it->second);
+                stored_keys.emplace_back(it->first);
+            }
+            else if (injection_ == injection_mode::eager)
+            {
+                inject_into_process(it->first, it->second.text, override_system);
+            }
         }
 
+        if (interpolate)
+            finish_load(stored_keys, override_system);
+    }
+
+    std::size_t
+    env::export_to_process(const std::optional<bool> override_system) const
+    {
+        const bool should_override = resolve_override(override_system);
+        expand_all_pending();
+
 #ifdef _WIN32
-        char* buffer = nullptr;
-        size_t size = 0;
-        if (_dupenv_s(&buffer, &size, key.data()) == 0 && buffer != nullptr)
+        std::size_t count = 0;
+        for (const auto& [key, value] : env_vars_)
         {
-            std::string value(buffer);
-            free(buffer);
-            if (!value.empty())
+            char* existing_env = nullptr;
+            size_t size;
+            _dupenv_s(&existing_env, &size, key.c_str());
+            const bool should_set = should_override || !existing_env ||
+                *existing_env == '\0';
+            if (existing_env)
+                free(existing_env);
+
+            if (should_set)
             {
-                return value;
+                _putenv_s(key.c_str(), value.text.c_str());
+                ++count;
             }
         }
+        return count;
 #else
-        if (const char* value = std::getenv(key.data()))
+        char**& environment = process_environ();
+
+        // Index the current entries by name; like getenv, the first wins
+        std::unordered_map<std::string_view, std::size_t> existing;
+        std::size_t old_count = 0;
+        for (; environment != nullptr && environment[old_count] != nullptr;
+             ++old_count)
         {
-            if (*value != '\0')
+            const std::string_view entry(environment[old_count]);
+            if (const auto eq = entry.find('='); eq != std::string_view::npos)
+                existing.emplace(entry.substr(0, eq), old_count);
+        }
+
+        constexpr std::size_t append = static_cast<std::size_t>(-1);
+        std::vector<std::pair<const decltype(env_vars_)::value_type*, std::size_t>>
+            updates;
+        std::size_t string_bytes = 0;
+        for (const auto& entry : env_vars_)
+        {
+            const auto& [key, value] = entry;
+            std::size_t slot = append;
+            if (const auto it = existing.find(key); it != existing.end())
             {
-                return std::string(value);
+                const std::string_view current =
+                    std::string_view(environment[it->second]).substr(key.size() + 1);
+                if ((!should_override && !current.empty()) ||
+                    current == value.text)
+                {
+                    continue;
+                }
+                slot = it->second;
             }
+
+            updates.emplace_back(&entry, slot);
+            string_bytes += key.size() + value.text.size() + 2;
+        }
+
+        if (updates.empty())
+            return 0;
+
+        std::size_t new_count = old_count;
+        for (const auto& update : updates)
+            new_count += update.second == append ? 1 : 0;
+
+        // One block for the pointer array and all "KEY=VALUE" strings. It is
+        // deliberately leaked: getenv results may point into it indefinitely.
+        const std::size_t array_bytes = (new_count + 1) * sizeof(char*);
+        auto* block =
+            static_cast<char*>(std::malloc(array_bytes + string_bytes));
+        if (block == nullptr)
+            throw std::bad_alloc();
+
+        auto** array = reinterpret_cast<char**>(block);
+        std::copy_n(environment, old_count, array);
+        char* cursor = block + array_bytes;
+        std::size_t next = old_count;
+        for (const auto& [entry, slot] : updates)
+        {
+            const auto& [key, value] = *entry;
+            array[slot == append ? next++ : slot] = cursor;
+            cursor = std::ranges::copy(key, cursor).out;
+            *cursor++ = '=';
+            cursor = std::ranges::copy(value.text, cursor).out;
+            *cursor++ = '\0';
         }
+        array[new_count] = nullptr;
+
+        environment = array;
+        return updates.size();
 #endif
+    }
 
+    std::optional<std::string_view>
+    env::get_view_miss(const std::string_view key) const
+    {
+        const auto value = system_fallback(key);
+        count_fallback(key, value.has_value());
+        return value;
+    }
+
+    const env::stored_value* env::find_captured(const std::string_view key) const
+    {
+        const auto it = system_vars_.find(key);
+        return it == system_vars_.end() ? nullptr : &it->second;
+    }
+
+    std::optional<std::string_view>
+    env::system_fallback(const std::string_view key) const
+    {
+        if (!system_captured_)
+            return system_view(key);
+
+        if (const stored_value* captured = find_captured(key))
+            return std::string_view(captured->text);
 
         return std::nullopt;
     }
 
+    std::optional<std::string_view> env::inherited_value(const std::string_view key) const
+    {
+        auto it = inherited_.find(key);
+        if (it == inherited_.end())
+        {
+            std::optional<std::string> copy;
+            if (const auto value = system_fallback(key))
+                copy.emplace(*value);
+            it = inherited_.emplace(std::string(key), std::move(copy)).first;
+        }
+
+        if (!it->second.has_value())
+            return std::nullopt;
+        return std::string_view(*it->second);
+    }
+
+    void env::capture_system_environment()
+    {
+#ifdef _WIN32
+        // Windows names are case-insensitive, as getenv treats them
+        constexpr key_case policy = key_case::insensitive;
+#else
+        const key_case policy = case_policy();
+#endif
+        storage captured = make_storage(policy, env_vars_.get_allocator().resource());
+
+        const auto add = [&](const std::string_view entry)
+        {
+            // Windows keeps per-drive directories as "=C:=C:\dir"; skip them
+            if (entry.empty() || entry.front() == '=')
+                return;
+
+            const auto eq = entry.find('=');
+            if (eq == std::string_view::npos || eq + 1 == entry.size())
+                return;
+
+            // Like getenv, the first occurrence of a name wins
+            const auto name = entry.substr(0, eq);
+            if (!captured.contains(name))
+                captured.emplace(name, entry.substr(eq + 1));
+        };
+
+#ifdef _WIN32
+        wchar_t* block = GetEnvironmentStringsW();
+        if (block == nullptr)
+            throw std::runtime_error("GetEnvironmentStringsW failed");
+
+        std::string narrow;
+        for (const wchar_t* entry = block; *entry != L'\0';)
+        {
+            const int length = static_cast<int>(std::wcslen(entry));
+            const int bytes = WideCharToMultiByte(CP_ACP, 0, entry, length,
+                                                  nullptr, 0, nullptr, nullptr);
+            narrow.resize(static_cast<std::size_t>(bytes));
+            WideCharToMultiByte(CP_ACP, 0, entry, length, narrow.data(), bytes,
+                                nullptr, nullptr);
+            add(narrow);
+            entry += length + 1;
+        }
+        FreeEnvironmentStringsW(block);
+#else
+        for (char** entry = process_environ();
+             entry != nullptr && *entry != nullptr; ++entry)
+        {
+            add(*entry);
+        }
+#endif
+
+        system_vars_ = std::move(captured);
+        system_captured_ = true;
+    }
+
+    void env::release_system_environment() noexcept
+    {
+        system_vars_.clear();
+        system_captured_ = false;
+    }
+
+    std::optional<std::string_view>
+    env::system_view(const std::string_view key)
+    {
+        return with_c_str(
+            key,
+            [](const char* c_key) -> std::optional<std::string_view>
+            {
+                // _dupenv_s would hand back an owned copy on Windows, so
+                // use getenv there too: a view has to point at the CRT's
+                // own environment block.
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4996)
+#endif
+                const char* value = std::getenv(c_key);
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+                if (value != nullptr && *value != '\0')
+                {
+                    return std::string_view(value);
+                }
+
+                return std::nullopt;
+            });
+    }
     std::string env::require(const std::string_view key)
     {
-        if (const auto val = get(key))
-            return *val;
+        if (const auto val = get_view(key))
+            return std::string(*val);
 
         throw std::runtime_error("Required environment variable missing: " +
                                  std::string(key));
     }
 
-    void env::parse_env_file(const std::filesystem::path& path,
-                             const bool override_system)
+    env_snapshot env::freeze() const
+    {
+        expand_all_pending();
+
+        std::vector<std::pair<std::string_view, std::string_view>> entries;
+        entries.reserve(env_vars_.size());
+        for (const auto& [key, value] : env_vars_)
+            entries.emplace_back(key, value.text);
+
+        return env_snapshot::from_entries(entries);
+    }
+
+    env_stats env::stats([[maybe_unused]] const std::size_t top) const
     {
-        std::ifstream file(path);
-        if (!file.is_open())
+        env_stats result;
+#ifdef DOT_ENV_ENABLE_STATS
+        result.loads = loads_;
+        result.bytes_parsed = bytes_parsed_;
+        result.parse_time = parse_time_;
+        result.entries = env_vars_.size();
+
+        // A name can have been both loaded and looked up in the system
+        // environment, e.g. before a load or after a reload removed it
+        std::unordered_map<std::string_view, key_stats> by_key;
+        for (const auto& [key, value] : env_vars_)
         {
-            std::cerr << "Failed to open env file: " << path << '\n';
-            return;
+            const std::uint64_t hits = value.lookups.load(std::memory_order_relaxed);
+            result.hits += hits;
+            if (hits != 0)
+                by_key[key].hits = hits;
+        }
+        // by_key refers to the names, so keep the copy alive
+        const auto fallbacks = fallback_stats_.copy();
+        for (const auto& [key, counts] : fallbacks)
+        {
+            result.fallbacks += counts.found;
+            result.misses += counts.missing;
+            auto& entry = by_key[key];
+            entry.fallbacks = counts.found;
+            entry.misses = counts.missing;
         }
 
-        std::string line;
-        while (std::getline(file, line))
+        std::vector<key_stats> keys;
+        keys.reserve(by_key.size());
+        for (auto& [key, entry] : by_key)
         {
-            // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            entry.key = key;
+            keys.push_back(std::move(entry));
+        }
 
-            if (line.empty() || line[0] == '#')
-                continue;
+        const auto hotter = [](const key_stats& a, const key_stats& b)
+        {
+            if (a.lookups() != b.lookups())
+                return a.lookups() > b.lookups();
+            return a.key < b.key;
+        };
+        const auto count = std::min(top, keys.size());
+        std::ranges::partial_sort(keys, keys.begin() + static_cast<std::ptrdiff_t>(count),
+                                  hotter);
+        keys.resize(count);
+        result.hottest = std::move(keys);
+#endif
+        return result;
+    }
 
-            const size_t eq_pos = line.find('=');
-            if (eq_pos == std::string::npos)
-                continue;
+    void env::reset_stats() noexcept
+    {
+#ifdef DOT_ENV_ENABLE_STATS
+        for (const auto& [key, value] : env_vars_)
+            value.lookups.store(0, std::memory_order_relaxed);
+        fallback_stats_.clear();
+        loads_ = 0;
+        bytes_parsed_ = 0;
+        parse_time_ = std::chrono::nanoseconds{0};
+#endif
+    }
 
-            std::string key = line.substr(0, eq_pos);
-            std::string value = line.substr(eq_pos + 1);
+    void env::mark_references(stored_value& value)
+    {
+        if (detail::has_references(value.text))
+        {
+            value.raw = value.text;
+            value.pending = true;
+        }
+    }
+
+    void env::expand_pending(const std::span<const std::string_view> roots) const
+    {
+        constexpr std::size_t no_node = static_cast<std::size_t>(-1);
+
+        // Pending values reachable from roots, in discovery order, and the
+        // pending values each of them references
+        std::vector<const storage::value_type*> nodes;
+        std::vector<std::vector<std::size_t>> dependencies;
+        std::unordered_map<std::string_view, std::size_t> index;
+        const auto visit = [&](const std::string_view name)
+        {
+            const auto it = env_vars_.find(name);
+            if (it == env_vars_.end() || !it->second.pending)
+                return no_node;
+
+            const auto [slot, inserted] =
+                index.try_emplace(std::string_view(it->first), nodes.size());
+            if (inserted)
+            {
+                nodes.push_back(&*it);
+                dependencies.emplace_back();
+            }
+            return slot->second;
+        };
 
-            // Remove surrounding whitespace
-            key.erase(0, key.find_first_not_of(" \t\r\n"));
-            key.erase(key.find_last_not_of(" \t\r\n") + 1);
-            value.erase(0, value.find_first_not_of(" \t\r\n"));
-            value.erase(value.find_last_not_of(" \t\r\n") + 1);
+        for (const auto root : roots)
+            visit(root);
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            detail::for_each_reference(
+                nodes[i]->second.raw,
+                [&](const std::string_view name)
+                {
+                    if (const auto dependency = visit(name); dependency != no_node)
+                        dependencies[i].push_back(dependency);
+                });
+        }
 
-            if (!value.empty() && value.front() == '"' && value.back() == '"')
+        // Values of a cycle are all still pending while the cycle expands.
+        // A reference to one of them, such as PATH=${PATH}:/opt, resolves
+        // from the system environment; only if that has nothing either is
+        // the cycle broken there.
+        bool cycle_broken = false;
+        const auto resolve =
+            [&](const std::string_view name) -> std::optional<std::string_view>
+        {
+            if (const auto it = env_vars_.find(name); it != env_vars_.end())
             {
-                value = value.substr(1, value.length() - 2);
+                if (!it->second.pending)
+                    return std::string_view(it->second.text);
+
+                auto system = inherited_value(it->first);
+                cycle_broken = cycle_broken || !system.has_value();
+                return system;
             }
+            return system_fallback(name);
+        };
 
-            if (key.empty() || value.empty())
+        // Expands one strongly connected component, once everything it
+        // references outside itself is final. Every member is expanded
+        // before any of them is stored, so references within a cycle see
+        // the same thing whichever member is reached first, and the result
+        // does not depend on the traversal order.
+        std::vector<std::string> expanded;
+        std::vector<bool> broken;
+        const auto expand_component = [&](const std::span<const std::size_t> members)
+        {
+            expanded.resize(members.size());
+            broken.assign(members.size(), false);
+            for (std::size_t m = 0; m < members.size(); ++m)
             {
-                std::cerr << "Invalid line in env file: " << line << std::endl;
+                expanded[m].clear();
+                cycle_broken = false;
+                detail::expand_references(nodes[members[m]]->second.raw, resolve,
+                                          expanded[m]);
+                broken[m] = cycle_broken;
+            }
+
+            for (std::size_t m = 0; m < members.size(); ++m)
+            {
+                const auto& [key, value] = *nodes[members[m]];
+                if (broken[m])
+                {
+                    report(severity::warning, [&]
+                           {
+                               return diagnostic{diagnostic::kind::cyclic_reference,
+                                                 severity::warning, {}, 0, 0,
+                                                 std::string(key)};
+                           });
+                }
+                value.text.assign(expanded[m]);
+                value.pending = false;
+                value.cached_type = nullptr;
+            }
+        };
+
+        // Tarjan's algorithm, iteratively so long reference chains cannot
+        // overflow the stack. It completes each component after all the
+        // components it references.
+        std::vector<std::size_t> number(nodes.size(), no_node);
+        std::vector<std::size_t> low(nodes.size(), 0);
+        std::vector<bool> on_stack(nodes.size(), false);
+        std::vector<std::size_t> component_stack;
+        // Node and the next of its dependencies to look at
+        std::vector<std::pair<std::size_t, std::size_t>> call_stack;
+        std::vector<std::size_t> members;
+        std::size_t counter = 0;
+        const auto enter = [&](const std::size_t node)
+        {
+            number[node] = low[node] = counter++;
+            component_stack.push_back(node);
+            on_stack[node] = true;
+            call_stack.emplace_back(node, 0);
+        };
+
+        for (std::size_t root = 0; root < nodes.size(); ++root)
+        {
+            if (number[root] != no_node)
                 continue;
+
+            enter(root);
+            while (!call_stack.empty())
+            {
+                auto& [node, next] = call_stack.back();
+                if (next < dependencies[node].size())
+                {
+                    const std::size_t dependency = dependencies[node][next++];
+                    if (number[dependency] == no_node)
+                        enter(dependency);
+                    else if (on_stack[dependency])
+                        low[node] = std::min(low[node], number[dependency]);
+                    continue;
+                }
+
+                const std::size_t finished = node;
+                call_stack.pop_back();
+                if (!call_stack.empty())
+                {
+                    const std::size_t caller = call_stack.back().first;
+                    low[caller] = std::min(low[caller], low[finished]);
+                }
+                if (low[finished] != number[finished])
+                    continue;
+
+                members.clear();
+                std::size_t member;
+                do
+                {
+                    member = component_stack.back();
+                    component_stack.pop_back();
+                    on_stack[member] = false;
+                    members.push_back(member);
+                } while (member != finished);
+
+                // Report a cycle's members in discovery order
+                std::ranges::sort(members);
+                expand_component(members);
             }
+        }
+    }
+
+    void env::expand_all_pending() const
+    {
+        if (interpolation_ == interpolation_mode::none)
+            return;
+
+        std::vector<std::string_view> roots;
+        for (const auto& [key, value] : env_vars_)
+        {
+            if (value.pending)
+                roots.emplace_back(key);
+        }
+        expand_pending(roots);
+    }
+
+    bool env::parse_env_file(const std::filesystem::path& path,
+                             const bool override_system)
+    {
+        const auto file = detail::file_buffer::open(path);
+        if (!file.has_value())
+        {
+            report(severity::error, [&]
+                   {
+                       return diagnostic{diagnostic::kind::unreadable_file,
+                                         severity::error, path, 0, 0, {}};
+                   });
+            reload_state_.reset();
+            return false;
+        }
+
+        auto state = std::make_shared<detail::reload_state>();
+        parse_env_buffer(file->view(), override_system, state.get(), path);
+        reload_state_ = std::move(state);
+        return true;
+    }
+
+    void env::parse_env_buffer(const std::string_view content,
+                               const bool override_system,
+                               detail::reload_state* record,
+                               const std::filesystem::path& file,
+                               detail::stream_window* stream)
+    {
+        // A streamed load is timed as a whole, not per window
+        std::optional<parse_timer> timer;
+        if (stream == nullptr)
+            timer.emplace(*this, content.size());
+        line_locator locator(content, stream != nullptr ? stream->first_line : 1);
+        std::vector<detail::chunk> chunks;
+        std::size_t current_chunk = 0;
+        if (record != nullptr)
+        {
+            chunks = detail::split_chunks(content);
+            record->blocks.reserve(chunks.size());
+            if (!chunks.empty())
+                record->add_block(chunks.front());
+        }
+
+        // Values that may reference each other are injected once expanded
+        const bool interpolate = interpolation_ != interpolation_mode::none;
+        std::vector<std::string_view> parsed_keys;
+        std::string unescaped;
 
-            // Store in an internal map
-            auto [it, inserted] = env_vars_.emplace(key, value);
-            if (!inserted)
+        const auto store = [&](const detail::token& token)
+        {
+            if (record != nullptr)
             {
-                std::cerr << "Duplicate env key: " << key << ", overwriting.\n";
-                it->second = value;
+                // Tokens arrive in buffer order, so the chunk cursor
+                // only ever moves forward
+                const auto offset =
+                    static_cast<std::size_t>(token.key.data() - content.data());
+                while (offset >= chunks[current_chunk].offset +
+                           chunks[current_chunk].length)
+                {
+                    record->add_block(chunks[++current_chunk]);
+                }
+                record->add_key(token.key);
             }
 
-            // Check existing system environment variable
-#ifdef _WIN32
-            char* existing_env = nullptr;
-            size_t size;
-            _dupenv_s(&existing_env, &size, key.c_str());
-#else
-            const char* existing_env = std::getenv(key.c_str());
-#endif
+            // Only materialize owned strings once the entry is stored
+            const auto value = detail::value_text(token, unescaped);
+            auto it = env_vars_.find(token.key);
+            if (it == env_vars_.end())
+            {
+                it = env_vars_.emplace(token.key, value).first;
+            }
+            else
+            {
+                report(severity::info, [&]
+                       {
+                           const auto [line, column] = locator.locate(token.key.data());
+                           return diagnostic{diagnostic::kind::duplicate_key,
+                                             severity::info, file, line, column,
+                                             std::string(token.key)};
+                       });
+                it->second.assign(value);
+            }
 
-            // Decide whether to set the system environment variable
-            bool should_set = override_system || !existing_env ||
-                (existing_env && std::string(existing_env).empty());
+            if (interpolate)
+            {
+                if (!token.literal)
+                    mark_references(it->second);
+                parsed_keys.emplace_back(it->first);
+            }
+            else if (injection_ == injection_mode::eager)
+            {
+                inject_into_process(it->first, it->second.text, override_system);
+            }
+        };
+        const auto reject = [&](const std::string_view text, std::size_t)
+        {
+            report(severity::warning, [&]
+                   {
+                       const auto [line, column] =
+                           locator.locate(invalid_line_position(text));
+                       return diagnostic{diagnostic::kind::invalid_line,
+                                         severity::warning, file, line, column,
+                                         std::string(text)};
+                   });
+        };
 
-            if (should_set)
+        if (stream != nullptr)
+        {
+            // A window may end inside a quoted value; leave that for the next
+            stream->consumed = detail::tokenize_range(content, 0, content.size(),
+                                                      stream->last, store, reject);
+        }
+        else if (const auto slice_count = parse_slices(parse_threads_, content.size());
+                 slice_count <= 1)
+        {
+            detail::tokenize(content, store, reject);
+        }
+        else
+        {
+            // Slices are stored in buffer order, so duplicates and the
+            // chunk cursor behave exactly as in the serial pass
+            const auto slices = detail::tokenize_parallel(content, slice_count);
+            std::size_t token_count = 0;
+            for (const auto& slice : slices)
+                token_count += slice.tokens.size();
+            env_vars_.reserve(env_vars_.size() + token_count);
+
+            for (const auto& slice : slices)
+            {
+                // Interleave rejected lines with tokens by position
+                auto invalid = slice.invalid_lines.begin();
+                for (const auto& token : slice.tokens)
+                {
+                    for (; invalid != slice.invalid_lines.end() &&
+                         invalid->data() < token.key.data();
+                         ++invalid)
+                    {
+                        reject(*invalid, 0);
+                    }
+                    store(token);
+                }
+                for (; invalid != slice.invalid_lines.end(); ++invalid)
+                    reject(*invalid, 0);
+            }
+        }
+
+        while (record != nullptr && current_chunk + 1 < chunks.size())
+            record->add_block(chunks[++current_chunk]);
+
+        if (stream != nullptr)
+        {
+            stream->first_line += static_cast<std::size_t>(
+                std::ranges::count(content.substr(0, stream->consumed), '\n'));
+            stream->parsed_keys.insert(stream->parsed_keys.end(), parsed_keys.begin(),
+                                       parsed_keys.end());
+        }
+        else if (interpolate)
+        {
+            finish_load(parsed_keys, override_system);
+        }
+    }
+
+    load_result env::load_from_buffer(const std::span<const char> content,
+                                      const std::optional<bool> override_system)
+    {
+        const bool should_override = resolve_override(override_system);
+        begin_load();
+        parse_env_buffer({content.data(), content.size()}, should_override);
+        return end_load(1);
+    }
+
+    template <class Read>
+    load_result env::load_streamed(Read&& read, const bool override_system)
+    {
+        constexpr std::size_t window_bytes = 64 * 1024;
+
+        begin_load();
+        [[maybe_unused]] parse_timer timer(*this, 0);
+        detail::stream_window stream;
+        std::string window(window_bytes, '\0');
+        std::size_t filled = 0;
+        bool failed = false;
+        // Nothing could be tokenized; wait for a full window before retrying
+        bool stalled = false;
+        for (bool done = false; !done;)
+        {
+            // Only a line or quoted value longer than the window makes it grow
+            if (filled == window.size())
+            {
+                window.resize(window.size() * 2);
+                stalled = false;
+            }
+
+            const auto got = read(window.data() + filled, window.size() - filled);
+            failed = got < 0;
+            done = got <= 0;
+            if (got > 0)
+                filled += static_cast<std::size_t>(got);
+
+            // Tokenize complete lines only; the rest waits for more input
+            const std::string_view data(window.data(), filled);
+            const std::size_t complete = done ? filled : data.rfind('\n') + 1;
+            if (complete == 0 || (stalled && !done))
+                continue;
+
+            stream.last = done;
+            parse_env_buffer(data.substr(0, complete), override_system, nullptr, {},
+                             &stream);
+            const std::size_t consumed = stream.consumed;
+            stalled = consumed == 0;
+            timer.add_bytes(consumed);
+            std::memmove(window.data(), window.data() + consumed, filled - consumed);
+            filled -= consumed;
+        }
+
+        if (interpolation_ != interpolation_mode::none)
+            finish_load(stream.parsed_keys, override_system);
+
+        if (failed)
+        {
+            report(severity::error, []
+                   {
+                       return diagnostic{diagnostic::kind::unreadable_file,
+                                         severity::error, {}, 0, 0, {}};
+                   });
+        }
+        return end_load(failed ? 0 : 1);
+    }
+
+    load_result env::load_from_stream(std::istream& in,
+                                      const std::optional<bool> override_system)
+    {
+        return load_streamed(
+            [&](char* data, const std::size_t size) -> std::ptrdiff_t
+            {
+                in.read(data, static_cast<std::streamsize>(size));
+                if (in.bad())
+                    return -1;
+                return static_cast<std::ptrdiff_t>(in.gcount());
+            },
+            resolve_override(override_system));
+    }
+
+    load_result env::load_from_fd(const int fd, const std::optional<bool> override_system)
+    {
+        const bool should_override = resolve_override(override_system);
+#ifndef _WIN32
+        if (const auto file = detail::file_buffer::map(fd))
+        {
+            // The mapping covers the whole file; start where the caller
+            // left the offset and move it to the end, as reading would
+            const std::string_view view = file->view();
+            const off_t offset = lseek(fd, 0, SEEK_CUR);
+            const std::size_t start =
+                offset > 0 ? std::min(static_cast<std::size_t>(offset), view.size()) : 0;
+            lseek(fd, 0, SEEK_END);
+
+            begin_load();
+            parse_env_buffer(view.substr(start), should_override);
+            return end_load(1);
+        }
+#endif
+
+        return load_streamed(
+            [fd](char* data, const std::size_t size) -> std::ptrdiff_t
             {
 #ifdef _WIN32
-                _putenv_s(key.c_str(), value.c_str());
-                if (existing_env)
-                    free(existing_env);
+                return _read(fd, data, static_cast<unsigned>(
+                                 std::min<std::size_t>(size, INT_MAX)));
 #else
-                setenv(key.c_str(), value.c_str(), 1);
+                for (;;)
+                {
+                    const auto got = ::read(fd, data, size);
+                    if (got >= 0 || errno != EINTR)
+                        return got;
+                }
 #endif
+            },
+            should_override);
+    }
+
+    void env::finish_load(const std::span<const std::string_view> keys,
+                          const bool override_system)
+    {
+        if (interpolation_ == interpolation_mode::eager ||
+            (interpolation_ == interpolation_mode::lazy &&
+             injection_ == injection_mode::eager))
+        {
+            expand_pending(keys);
+        }
+
+        if (injection_ == injection_mode::eager)
+        {
+            for (const auto key : keys)
+            {
+                const auto it = env_vars_.find(key);
+                inject_into_process(it->first, it->second.text, override_system);
             }
         }
     }
 
+    load_result env::load_layers(const std::span<const std::string_view> filenames,
+                                 const std::optional<bool> override_system)
+    {
+        const bool should_override = resolve_override(override_system);
+        begin_load();
+        [[maybe_unused]] parse_timer timer(*this, 0);
+        const auto directory = std::filesystem::current_path();
+
+        struct layer
+        {
+            std::filesystem::path path;
+            std::optional<detail::file_buffer> file;
+            std::vector<detail::token> tokens;
+            std::vector<std::string_view> invalid_lines;
+            bool found = false;
+        };
+
+        const auto read_layer = [](layer& l)
+        {
+            std::error_code error;
+            if (!std::filesystem::is_regular_file(l.path, error))
+                return;
+
+            l.found = true;
+            l.file = detail::file_buffer::open(l.path);
+            if (!l.file.has_value())
+                return;
+
+            detail::tokenize(
+                l.file->view(),
+                [&](const detail::token& token) { l.tokens.push_back(token); },
+                [&](const std::string_view line, std::size_t)
+                { l.invalid_lines.push_back(line); });
+        };
+
+        std::vector<layer> layers;
+        layers.reserve(filenames.size());
+        for (const auto filename : filenames)
+        {
+            if (!filename.empty())
+                layers.push_back({directory / filename, std::nullopt, {}, {}, false});
+        }
+
+        if (layers.size() == 1)
+        {
+            read_layer(layers.front());
+        }
+        else
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(layers.size());
+            for (auto& l : layers)
+                workers.emplace_back(read_layer, std::ref(l));
+        }
+        for (const auto& l : layers)
+        {
+            if (l.file.has_value())
+                timer.add_bytes(l.file->view().size());
+        }
+
+        // Later layers win. Only a key repeated within one file is a
+        // duplicate; overriding an earlier layer is the point of layering.
+        struct winner
+        {
+            detail::token token;
+            std::size_t layer;
+        };
+        std::unordered_map<std::string_view, winner, detail::key_hash, detail::key_equal>
+            merged(0, env_vars_.hash_function(), env_vars_.key_eq());
+        std::size_t loaded = 0;
+        for (std::size_t i = 0; i < layers.size(); ++i)
+        {
+            const layer& l = layers[i];
+            if (!l.file.has_value())
+            {
+                if (l.found)
+                {
+                    report(severity::error, [&]
+                           {
+                               return diagnostic{diagnostic::kind::unreadable_file,
+                                                 severity::error, l.path, 0, 0, {}};
+                           });
+                }
+                continue;
+            }
+
+            ++loaded;
+            line_locator locator(l.file->view());
+            auto invalid = l.invalid_lines.begin();
+            const auto reject_until = [&](const char* position)
+            {
+                for (; invalid != l.invalid_lines.end() && invalid->data() < position;
+                     ++invalid)
+                {
+                    report(severity::warning, [&]
+                           {
+                               const auto [line, column] =
+                                   locator.locate(invalid_line_position(*invalid));
+                               return diagnostic{diagnostic::kind::invalid_line,
+                                                 severity::warning, l.path, line,
+                                                 column, std::string(*invalid)};
+                           });
+                }
+            };
+
+            for (const auto& token : l.tokens)
+            {
+                reject_until(token.key.data());
+                const auto [it, inserted] =
+                    merged.try_emplace(token.key, winner{token, i});
+                if (inserted)
+                    continue;
+
+                if (it->second.layer == i)
+                {
+                    report(severity::info, [&]
+                           {
+                               const auto [line, column] =
+                                   locator.locate(token.key.data());
+                               return diagnostic{diagnostic::kind::duplicate_key,
+                                                 severity::info, l.path, line,
+                                                 column, std::string(token.key)};
+                           });
+                }
+                it->second = {token, i};
+            }
+            reject_until(l.file->view().data() + l.file->view().size());
+        }
+
+        if (loaded == 0)
+            return end_load(0);
+
+        const bool interpolate = interpolation_ != interpolation_mode::none;
+        std::vector<std::string_view> stored_keys;
+        stored_keys.reserve(merged.size());
+        env_vars_.reserve(env_vars_.size() + merged.size());
+        std::string unescaped;
+        for (const auto& [key, entry] : merged)
+        {
+            const auto value = detail::value_text(entry.token, unescaped);
+            auto it = env_vars_.find(key);
+            if (it == env_vars_.end())
+                it = env_vars_.emplace(key, value).first;
+            else
+                it->second.assign(value);
+
+            if (interpolate && !entry.token.literal)
+                mark_references(it->second);
+            stored_keys.emplace_back(it->first);
+        }
+        finish_load(stored_keys, should_override);
+
+        for (auto l = layers.rbegin(); l != layers.rend(); ++l)
+        {
+            if (l->file.has_value())
+            {
+                loaded_path_ = std::move(l->path);
+                break;
+            }
+        }
+        reload_state_.reset();
+        return end_load(loaded);
+    }
+
+    std::optional<env_diff>
+    env::reload_env(const std::optional<bool> override_system)
+    {
+        const bool should_override = resolve_override(override_system);
+
+        if (loaded_path_.empty() || !reload_state_)
+            return std::nullopt;
+
+        const auto file = detail::file_buffer::open(loaded_path_);
+        if (!file.has_value())
+            return std::nullopt;
+
+        const std::string_view content = file->view();
+        [[maybe_unused]] parse_timer timer(*this, content.size());
+        const detail::reload_state& previous = *reload_state_;
+        const auto chunks = detail::split_chunks(content);
+
+        // Pair every new chunk with an unused old block of identical hash
+        // and length; whatever is left over on either side has changed
+        std::unordered_multimap<std::uint64_t, std::size_t> old_blocks;
+        old_blocks.reserve(previous.blocks.size());
+        for (std::size_t i = 0; i < previous.blocks.size(); ++i)
+            old_blocks.emplace(previous.blocks[i].hash, i);
+
+        std::vector<bool> old_reused(previous.blocks.size(), false);
+        constexpr std::size_t no_match = static_cast<std::size_t>(-1);
+        std::vector<std::size_t> match(chunks.size(), no_match);
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            auto [first, last] = old_blocks.equal_range(chunks[i].hash);
+            for (; first != last; ++first)
+            {
+                const auto& block = previous.blocks[first->second];
+                if (block.length == chunks[i].length)
+                {
+                    match[i] = first->second;
+                    old_reused[first->second] = true;
+                    old_blocks.erase(first);
+                    break;
+                }
+            }
+        }
+
+        // A matched chunk that moved past others can change which of two
+        // assignments of a key comes last. Keep the longest run of matches
+        // that are still in their old order and treat the rest as changed.
+        {
+            std::vector<std::size_t> matched;
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+            {
+                if (match[i] != no_match)
+                    matched.push_back(i);
+            }
+
+            // tails[l]: the matched chunk ending the best run of length l + 1
+            std::vector<std::size_t> tails;
+            std::vector<std::size_t> predecessor(chunks.size(), no_match);
+            for (const std::size_t i : matched)
+            {
+                const auto slot = std::ranges::partition_point(
+                    tails, [&](const std::size_t t) { return match[t] < match[i]; });
+                if (slot != tails.begin())
+                    predecessor[i] = *std::prev(slot);
+                if (slot == tails.end())
+                    tails.push_back(i);
+                else
+                    *slot = i;
+            }
+
+            std::vector<bool> in_order(chunks.size(), false);
+            for (std::size_t i = tails.empty() ? no_match : tails.back(); i != no_match;
+                 i = predecessor[i])
+            {
+                in_order[i] = true;
+            }
+            for (const std::size_t i : matched)
+            {
+                if (!in_order[i])
+                {
+                    old_reused[match[i]] = false;
+                    match[i] = no_match;
+                }
+            }
+        }
+
+        // Keys assigned anywhere in a changed region may have a new value
+        std::unordered_set<std::string_view, detail::key_hash, detail::key_equal>
+            touched(0, env_vars_.hash_function(), env_vars_.key_eq());
+        for (std::size_t i = 0; i < previous.blocks.size(); ++i)
+        {
+            if (old_reused[i])
+                continue;
+            const auto& block = previous.blocks[i];
+            for (std::size_t k = 0; k < block.key_count; ++k)
+                touched.insert(previous.key(block.first_key + k));
+        }
+
+        line_locator locator(content);
+        std::vector<std::vector<detail::token>> fresh(chunks.size());
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (match[i] != no_match)
+                continue;
+
+            detail::tokenize(
+                content.substr(chunks[i].offset, chunks[i].length),
+                [&](const detail::token& token)
+                {
+                    fresh[i].push_back(token);
+                    touched.insert(token.key);
+                },
+                [&](const std::string_view text, std::size_t)
+                {
+                    report(severity::warning, [&]
+                           {
+                               const auto [line, column] =
+                                   locator.locate(invalid_line_position(text));
+                               return diagnostic{diagnostic::kind::invalid_line,
+                                                 severity::warning, loaded_path_,
+                                                 line, column, std::string(text)};
+                           });
+                });
+        }
+
+        // Resolve the last assignment of every touched key in file order.
+        // Unchanged chunks only need tokenizing again when they assign a
+        // touched key, e.g. when a later duplicate was just deleted.
+        auto state = std::make_shared<detail::reload_state>();
+        state->blocks.reserve(chunks.size());
+        std::unordered_map<std::string_view, detail::token, detail::key_hash,
+                           detail::key_equal>
+            resolved(0, env_vars_.hash_function(), env_vars_.key_eq());
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            state->add_block(chunks[i]);
+            if (match[i] == no_match)
+            {
+                for (const auto& token : fresh[i])
+                {
+                    resolved[token.key] = token;
+                    state->add_key(token.key);
+                }
+                continue;
+            }
+
+            const auto& block = previous.blocks[match[i]];
+            bool assigns_touched = false;
+            for (std::size_t k = 0; k < block.key_count; ++k)
+            {
+                const auto key = previous.key(block.first_key + k);
+                assigns_touched = assigns_touched || touched.contains(key);
+                state->add_key(key);
+            }
+
+            if (assigns_touched)
+            {
+                detail::tokenize(
+                    content.substr(chunks[i].offset, chunks[i].length),
+                    [&](const detail::token& token)
+                    {
+                        if (touched.contains(token.key))
+                            resolved[token.key] = token;
+                    },
+                    [](std::string_view, std::size_t) {});
+            }
+        }
+
+        const bool interpolate = interpolation_ != interpolation_mode::none;
+        const bool inject = injection_ == injection_mode::eager;
+
+        env_diff diff;
+        // Added and changed keys, injected once all values are final
+        std::vector<std::string_view> updated;
+        // Expanded text of changed values, in case they expand as before
+        std::vector<std::pair<std::string_view, std::string>> replaced_text;
+        std::string unescaped;
+        for (const auto key : touched)
+        {
+            const auto it = env_vars_.find(key);
+            const auto resolved_it = resolved.find(key);
+            if (resolved_it == resolved.end())
+            {
+                if (it == env_vars_.end())
+                    continue;
+
+                diff.removed.emplace_back(key);
+                if (inject)
+                    remove_from_process(it->first, it->second.text);
+                env_vars_.erase(it);
+                continue;
+            }
+
+            const detail::token& token = resolved_it->second;
+            const auto value = detail::value_text(token, unescaped);
+            if (it == env_vars_.end())
+            {
+                diff.added.emplace_back(key);
+                const auto inserted = env_vars_.emplace(key, value).first;
+                if (interpolate && !token.literal)
+                    mark_references(inserted->second);
+                updated.emplace_back(inserted->first);
+            }
+            else if (it->second.source() != value ||
+                     // Same text, but quoted differently
+                     (interpolate && it->second.raw.empty() !=
+                          (token.literal || !detail::has_references(value))))
+            {
+                diff.changed.emplace_back(key);
+                if (interpolate && !it->second.pending)
+                    replaced_text.emplace_back(it->first, it->second.text);
+                it->second.assign(value);
+                if (interpolate && !token.literal)
+                    mark_references(it->second);
+                updated.emplace_back(it->first);
+            }
+        }
+
+        if (interpolate && !diff.empty())
+        {
+            // Any value with references may expand differently now; expand
+            // them all again and report the ones whose result changed
+            std::vector<std::string_view> templated;
+            std::vector<std::pair<std::string_view, std::string>> previous_text;
+            for (auto& [key, value] : env_vars_)
+            {
+                if (value.raw.empty())
+                    continue;
+
+                templated.emplace_back(key);
+                if (!value.pending)
+                {
+                    previous_text.emplace_back(key, value.text);
+                    value.pending = true;
+                }
+            }
+
+            if (interpolation_ == interpolation_mode::eager || inject)
+            {
+                expand_pending(templated);
+
+                const std::unordered_set<std::string_view> reported(
+                    updated.begin(), updated.end());
+                for (const auto& [key, text] : previous_text)
+                {
+                    if (std::string_view(env_vars_.find(key)->second.text) != text &&
+                        !reported.contains(key))
+                    {
+                        diff.changed.emplace_back(key);
+                        updated.push_back(key);
+                    }
+                }
+
+                // A new source can still expand to the same text
+                std::unordered_set<std::string_view> unchanged;
+                for (const auto& [key, text] : replaced_text)
+                {
+                    if (std::string_view(env_vars_.find(key)->second.text) == text)
+                        unchanged.insert(key);
+                }
+                if (!unchanged.empty())
+                {
+                    std::erase_if(diff.changed, [&](const std::string& key)
+                                  { return unchanged.contains(key); });
+                    std::erase_if(updated, [&](const std::string_view key)
+                                  { return unchanged.contains(key); });
+                }
+            }
+        }
+
+        if (inject)
+        {
+            for (const auto key : updated)
+            {
+                const auto it = env_vars_.find(key);
+                inject_into_process(it->first, it->second.text, should_override);
+            }
+        }
+
+        std::ranges::sort(diff.added);
+        std::ranges::sort(diff.changed);
+        std::ranges::sort(diff.removed);
+        reload_state_ = std::move(state);
+        return diff;
+    }
+
 } // namespace dot_env
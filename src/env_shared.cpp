@@ -0,0 +1,290 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "../include/env_shared.hpp"
+
+#ifndef _WIN32
+
+#include "file_buffer.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dot_env
+{
+    namespace detail
+    {
+        /**
+         * The whole contents of a control segment.
+         */
+        struct shared_control
+        {
+            char magic[8];
+            // Accessed through std::atomic_ref only; 0 until the first publish
+            alignas(std::atomic_ref<std::uint64_t>::required_alignment)
+            std::uint64_t generation;
+        };
+        static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free,
+                      "readers load the generation from a read-only mapping");
+    } // namespace detail
+
+    namespace
+    {
+        constexpr char control_magic[8] = {'D', 'O', 'T', 'E', 'N', 'V', 'S', '\0'};
+
+        [[nodiscard]] std::optional<std::string> segment_name(const std::string_view name)
+        {
+            const std::string_view bare = name.starts_with('/') ? name.substr(1) : name;
+            if (bare.empty() || bare.find('/') != std::string_view::npos)
+                return std::nullopt;
+
+            std::string result = "/";
+            result.append(bare);
+            return result;
+        }
+
+        [[nodiscard]] std::string data_segment(const std::string& name,
+                                               const std::uint64_t generation)
+        {
+            return name + "." + std::to_string(generation);
+        }
+
+        [[nodiscard]] std::uint64_t load_generation(const detail::shared_control& control) noexcept
+        {
+            // A lock-free load never writes, so the reader's mapping may be read-only
+            return std::atomic_ref(const_cast<std::uint64_t&>(control.generation))
+                .load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] mode_t mode_of(const std::filesystem::perms permissions) noexcept
+        {
+            // std::filesystem::perms uses the POSIX permission bits
+            return static_cast<mode_t>(permissions & std::filesystem::perms::mask);
+        }
+
+        // Reserves the pages up front, so a full /dev/shm fails here
+        // instead of raising SIGBUS on a later write through the mapping
+        [[nodiscard]] bool allocate(const int fd, const std::size_t size) noexcept
+        {
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+                return false;
+#ifdef __linux__
+            return posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#else
+            return true;
+#endif
+        }
+    } // namespace
+
+    shared_snapshot_publisher::shared_snapshot_publisher(
+        std::string name, detail::shared_control* control,
+        const std::filesystem::perms permissions) noexcept :
+        name_(std::move(name)),
+        control_(control),
+        permissions_(permissions)
+    {
+    }
+
+    shared_snapshot_publisher::shared_snapshot_publisher(
+        shared_snapshot_publisher&& other) noexcept :
+        name_(std::move(other.name_)),
+        control_(std::exchange(other.control_, nullptr)),
+        permissions_(other.permissions_)
+    {
+    }
+
+    shared_snapshot_publisher&
+    shared_snapshot_publisher::operator=(shared_snapshot_publisher&& other) noexcept
+    {
+        std::swap(name_, other.name_);
+        std::swap(control_, other.control_);
+        std::swap(permissions_, other.permissions_);
+        return *this;
+    }
+
+    shared_snapshot_publisher::~shared_snapshot_publisher()
+    {
+        if (control_ == nullptr)
+            return;
+
+        if (const std::uint64_t current = generation(); current != 0)
+            shm_unlink(data_segment(name_, current).c_str());
+        shm_unlink(name_.c_str());
+        munmap(control_, sizeof(detail::shared_control));
+    }
+
+    std::optional<shared_snapshot_publisher>
+    shared_snapshot_publisher::create(const std::string_view name,
+                                      const std::filesystem::perms permissions)
+    {
+        auto full_name = segment_name(name);
+        if (!full_name.has_value())
+            return std::nullopt;
+
+        const mode_t mode = mode_of(permissions);
+        const int fd = shm_open(full_name->c_str(), O_CREAT | O_RDWR, mode);
+        if (fd < 0)
+            return std::nullopt;
+
+        // The umask must not take away read access granted to workers
+        struct stat info{};
+        const bool usable = fchmod(fd, mode) == 0 && fstat(fd, &info) == 0 &&
+            (info.st_size == sizeof(detail::shared_control) ||
+             (info.st_size == 0 && allocate(fd, sizeof(detail::shared_control))));
+        void* view = usable
+            ? mmap(nullptr, sizeof(detail::shared_control), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        close(fd);
+        if (view == MAP_FAILED)
+            return std::nullopt;
+
+        auto* control = static_cast<detail::shared_control*>(view);
+        if (control->magic[0] == '\0')
+        {
+            std::memcpy(control->magic, control_magic, sizeof(control_magic));
+        }
+        else if (std::memcmp(control->magic, control_magic, sizeof(control_magic)) != 0)
+        {
+            munmap(view, sizeof(detail::shared_control));
+            return std::nullopt;
+        }
+
+        return shared_snapshot_publisher(std::move(*full_name), control, permissions);
+    }
+
+    bool shared_snapshot_publisher::publish(const env_snapshot& snapshot)
+    {
+        const std::uint64_t previous = generation();
+        const std::uint64_t next = previous + 1;
+        const std::string next_name = data_segment(name_, next);
+
+        // Left behind if an earlier publisher died halfway through a publish
+        shm_unlink(next_name.c_str());
+
+        const mode_t mode = mode_of(permissions_);
+        const int fd = shm_open(next_name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+        if (fd < 0)
+            return false;
+
+        const std::string_view payload = snapshot.payload();
+        const std::size_t size = env_snapshot::image_header_size + payload.size();
+        bool written = fchmod(fd, mode) == 0 && allocate(fd, size);
+        if (written)
+        {
+            void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            written = view != MAP_FAILED;
+            if (written)
+            {
+                char* out = static_cast<char*>(view);
+                snapshot.write_image_header(out, 0, 0);
+                if (!payload.empty())
+                    std::memcpy(out + env_snapshot::image_header_size, payload.data(),
+                                payload.size());
+                munmap(view, size);
+            }
+        }
+        close(fd);
+
+        if (!written)
+        {
+            shm_unlink(next_name.c_str());
+            return false;
+        }
+
+        // The segment is complete; readers that see the new generation can map it
+        std::atomic_ref(control_->generation).store(next, std::memory_order_release);
+        if (previous != 0)
+            shm_unlink(data_segment(name_, previous).c_str());
+        return true;
+    }
+
+    std::uint64_t shared_snapshot_publisher::generation() const noexcept
+    {
+        return load_generation(*control_);
+    }
+
+    shared_snapshot::shared_snapshot(
+        std::string name, std::shared_ptr<const detail::shared_control> control) noexcept :
+        name_(std::move(name)),
+        control_(std::move(control))
+    {
+    }
+
+    std::optional<shared_snapshot> shared_snapshot::open(const std::string_view name)
+    {
+        auto full_name = segment_name(name);
+        if (!full_name.has_value())
+            return std::nullopt;
+
+        const int fd = shm_open(full_name->c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return std::nullopt;
+
+        struct stat info{};
+        void* view = fstat(fd, &info) == 0 && info.st_size == sizeof(detail::shared_control)
+            ? mmap(nullptr, sizeof(detail::shared_control), PROT_READ, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        close(fd);
+        if (view == MAP_FAILED)
+            return std::nullopt;
+
+        std::shared_ptr<const detail::shared_control> control(
+            static_cast<const detail::shared_control*>(view),
+            [](const detail::shared_control* mapped)
+            {
+                munmap(const_cast<detail::shared_control*>(mapped),
+                       sizeof(detail::shared_control));
+            });
+        if (std::memcmp(control->magic, control_magic, sizeof(control_magic)) != 0)
+            return std::nullopt;
+
+        shared_snapshot reader(std::move(*full_name), std::move(control));
+        reader.refresh();
+        return reader;
+    }
+
+    bool shared_snapshot::stale() const noexcept
+    {
+        return load_generation(*control_) != generation_;
+    }
+
+    bool shared_snapshot::refresh()
+    {
+        const std::uint64_t current = load_generation(*control_);
+        if (current == generation_)
+            return false;
+
+        // Fails if a newer publish already unlinked it; the next refresh
+        // then picks up that one
+        const int fd = shm_open(data_segment(name_, current).c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+
+        auto mapping = detail::file_buffer::map(fd);
+        close(fd);
+        if (!mapping.has_value())
+            return false;
+
+        // Only the publisher can write the segment, so skip the checksum;
+        // the structure is still checked before any lookup trusts it
+        const auto owner = std::make_shared<const detail::file_buffer>(std::move(*mapping));
+        const std::string_view image = owner->view();
+        auto adopted = env_snapshot::from_image(image, owner, false);
+        if (!adopted.has_value())
+            return false;
+
+        snapshot_ = std::move(*adopted);
+        generation_ = current;
+        return true;
+    }
+} // namespace dot_env
+
+#endif // _WIN32
@@ -0,0 +1,369 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "../include/env_snapshot.hpp"
+
+#include "file_buffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace dot_env
+{
+    namespace
+    {
+        constexpr char cache_magic[8] = {'D', 'O', 'T', 'E', 'N', 'V', 'C', '\0'};
+        constexpr std::uint32_t cache_version = 1;
+        // Reads back byte-swapped on a machine of the other endianness
+        constexpr std::uint32_t cache_byte_order = 0x01020304;
+
+        /**
+         * The fixed-size start of a cache file; the snapshot data follows
+         * immediately, starting 8-byte aligned.
+         */
+        struct cache_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint64_t source_size;
+            std::int64_t source_mtime;
+            std::uint64_t count;
+            std::uint64_t slot_count;
+            std::uint64_t pool_size;
+            // detail::hash_key over all bytes after the header
+            std::uint64_t checksum;
+        };
+        static_assert(sizeof(cache_header) == 64);
+
+        struct source_stamp
+        {
+            std::uint64_t size;
+            std::int64_t mtime;
+        };
+
+        [[nodiscard]] std::optional<source_stamp>
+        stamp_of(const std::filesystem::path& source)
+        {
+            std::error_code error;
+            const auto size = std::filesystem::file_size(source, error);
+            if (error)
+                return std::nullopt;
+
+            const auto mtime = std::filesystem::last_write_time(source, error);
+            if (error)
+                return std::nullopt;
+
+            return source_stamp{
+                static_cast<std::uint64_t>(size),
+                static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+        }
+    } // namespace
+
+    env_snapshot env_snapshot::from_entries(
+        const std::span<const std::pair<std::string_view, std::string_view>>
+            entries)
+    {
+        std::vector<std::pair<std::string_view, std::string_view>> sorted(
+            entries.begin(), entries.end());
+        std::ranges::stable_sort(
+            sorted, {},
+            &std::pair<std::string_view, std::string_view>::first);
+
+        // Keep only the last occurrence of each key
+        auto out = sorted.begin();
+        for (auto it = sorted.begin(); it != sorted.end(); ++it)
+        {
+            if (std::next(it) != sorted.end() &&
+                std::next(it)->first == it->first)
+            {
+                continue;
+            }
+            *out++ = *it;
+        }
+        sorted.erase(out, sorted.end());
+
+        std::size_t pool_size = 0;
+        for (const auto& [key, value] : sorted)
+            pool_size += key.size() + value.size();
+
+        if (pool_size > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("env_snapshot string pool exceeds 4 GiB");
+
+        // Keep the index at most half full so probe sequences stay short
+        const std::size_t slot_count =
+            std::bit_ceil(std::max<std::size_t>(sorted.size() * 2, 2));
+
+        // One allocation: entries, then the hash index, then the pool
+        const std::size_t entries_bytes = sorted.size() * sizeof(entry);
+        const std::size_t slots_bytes = slot_count * sizeof(std::uint64_t);
+        const std::size_t words = (entries_bytes + slots_bytes + pool_size +
+                                   sizeof(std::uint64_t) - 1) /
+            sizeof(std::uint64_t);
+        const auto storage = std::make_shared<std::uint64_t[]>(words);
+
+        auto* table = reinterpret_cast<entry*>(storage.get());
+        auto* slots = storage.get() + entries_bytes / sizeof(std::uint64_t);
+        char* pool = reinterpret_cast<char*>(slots + slot_count);
+        const std::uint64_t slot_mask = slot_count - 1;
+
+        std::uint32_t offset = 0;
+        for (std::size_t i = 0; i < sorted.size(); ++i)
+        {
+            const auto& [key, value] = sorted[i];
+            table[i].key_offset = offset;
+            table[i].key_length = static_cast<std::uint32_t>(key.size());
+            std::memcpy(pool + offset, key.data(), key.size());
+            offset += static_cast<std::uint32_t>(key.size());
+
+            // Values sit right after their key, so a hit reads one region
+            table[i].value_offset = offset;
+            table[i].value_length = static_cast<std::uint32_t>(value.size());
+            std::memcpy(pool + offset, value.data(), value.size());
+            offset += static_cast<std::uint32_t>(value.size());
+
+            const std::uint64_t hash = detail::hash_key(key);
+            std::uint64_t slot = hash & slot_mask;
+            while (slots[slot] != 0)
+                slot = (slot + 1) & slot_mask;
+            slots[slot] = (hash & 0xFFFFFFFF00000000ull) | (i + 1);
+        }
+
+        env_snapshot snapshot;
+        snapshot.storage_ = storage;
+        snapshot.entries_ = table;
+        snapshot.slots_ = slots;
+        snapshot.slot_mask_ = slot_mask;
+        snapshot.pool_ = pool;
+        snapshot.count_ = sorted.size();
+        return snapshot;
+    }
+
+    static_assert(std::random_access_iterator<env_snapshot::iterator>);
+
+    std::ranges::subrange<env_snapshot::iterator>
+    env_snapshot::with_prefix(const std::string_view prefix) const noexcept
+    {
+        const entry* const last = entries_ + count_;
+        const entry* const first = std::partition_point(
+            entries_, last, [&](const entry& e) { return key_of(e) < prefix; });
+        const entry* const matches_end = std::partition_point(
+            first, last, [&](const entry& e) { return key_of(e).starts_with(prefix); });
+        return {iterator(first, pool_), iterator(matches_end, pool_)};
+    }
+
+    std::string_view env_snapshot::payload() const noexcept
+    {
+        if (count_ == 0)
+            return {};
+
+        const entry& last = entries_[count_ - 1];
+        const std::size_t pool_size = last.value_offset + last.value_length;
+        return {reinterpret_cast<const char*>(entries_),
+                static_cast<std::size_t>(pool_ + pool_size -
+                                         reinterpret_cast<const char*>(entries_))};
+    }
+
+    void env_snapshot::write_image_header(char* out, const std::uint64_t source_size,
+                                          const std::int64_t source_mtime) const noexcept
+    {
+        static_assert(sizeof(cache_header) == image_header_size);
+
+        cache_header header{};
+        std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.version = cache_version;
+        header.byte_order = cache_byte_order;
+        header.source_size = source_size;
+        header.source_mtime = source_mtime;
+
+        const std::string_view data = payload();
+        if (count_ != 0)
+        {
+            const entry& last = entries_[count_ - 1];
+            header.count = count_;
+            header.slot_count = slot_mask_ + 1;
+            header.pool_size = last.value_offset + last.value_length;
+        }
+        header.checksum = detail::hash_key(data);
+        std::memcpy(out, &header, sizeof(header));
+    }
+
+    bool env_snapshot::save_cache(const std::filesystem::path& cache,
+                                  const std::filesystem::path& source) const
+    {
+        const auto stamp = stamp_of(source);
+        if (!stamp.has_value())
+            return false;
+
+        char header[image_header_size];
+        write_image_header(header, stamp->size, stamp->mtime);
+        const std::string_view data = payload();
+
+        auto partial = cache;
+        partial += ".tmp";
+        {
+            std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+            out.write(header, sizeof(header));
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!out.flush())
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(partial, cache, error);
+        if (error)
+        {
+            std::filesystem::remove(partial, error);
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<env_snapshot>
+    env_snapshot::open_cache(const std::filesystem::path& cache,
+                             const std::filesystem::path& source)
+    {
+        const auto stamp = stamp_of(source);
+        if (!stamp.has_value())
+            return std::nullopt;
+
+        auto file = detail::file_buffer::open(cache);
+        if (!file.has_value() || file->view().size() < sizeof(cache_header))
+            return std::nullopt;
+
+        cache_header header;
+        std::memcpy(&header, file->view().data(), sizeof(header));
+        if (header.source_size != stamp->size || header.source_mtime != stamp->mtime)
+            return std::nullopt;
+
+        const auto mapping =
+            std::make_shared<const detail::file_buffer>(std::move(*file));
+        const std::string_view image = mapping->view();
+        return from_image(image, mapping, true);
+    }
+
+    std::optional<env_snapshot>
+    env_snapshot::from_image(const std::string_view image,
+                             std::shared_ptr<const void> owner,
+                             const bool verify_checksum)
+    {
+        if (image.size() < sizeof(cache_header))
+            return std::nullopt;
+
+        cache_header header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+            header.version != cache_version ||
+            header.byte_order != cache_byte_order)
+        {
+            return std::nullopt;
+        }
+
+        const std::string_view payload = image.substr(sizeof(cache_header));
+        const std::uint64_t limit = std::numeric_limits<std::uint32_t>::max();
+        if (header.count > limit || header.pool_size > limit ||
+            (header.count != 0 &&
+             (!std::has_single_bit(header.slot_count) ||
+              header.slot_count <= header.count ||
+              header.slot_count > payload.size())) ||
+            payload.size() != header.count * sizeof(entry) +
+                    header.slot_count * sizeof(std::uint64_t) +
+                    header.pool_size ||
+            reinterpret_cast<std::uintptr_t>(payload.data()) %
+                    alignof(std::uint64_t) != 0 ||
+            (verify_checksum && detail::hash_key(payload) != header.checksum))
+        {
+            return std::nullopt;
+        }
+
+        if (header.count == 0)
+            return env_snapshot{};
+
+        // The checksum only catches accidents; still make sure no entry or
+        // slot can point outside the image
+        const auto* table = reinterpret_cast<const entry*>(payload.data());
+        const auto* slots = reinterpret_cast<const std::uint64_t*>(
+            payload.data() + header.count * sizeof(entry));
+        for (std::size_t i = 0; i < header.count; ++i)
+        {
+            const entry& e = table[i];
+            if (std::uint64_t{e.key_offset} + e.key_length > header.pool_size ||
+                std::uint64_t{e.value_offset} + e.value_length > header.pool_size)
+            {
+                return std::nullopt;
+            }
+        }
+        std::size_t occupied = 0;
+        for (std::size_t i = 0; i < header.slot_count; ++i)
+        {
+            const std::uint64_t index = slots[i] & 0xFFFFFFFFull;
+            if (index > header.count)
+                return std::nullopt;
+            occupied += index != 0 ? 1 : 0;
+        }
+        if (occupied != header.count)
+            return std::nullopt;
+
+        env_snapshot snapshot;
+        snapshot.entries_ = table;
+        snapshot.slots_ = slots;
+        snapshot.slot_mask_ = header.slot_count - 1;
+        snapshot.pool_ = reinterpret_cast<const char*>(slots + header.slot_count);
+        snapshot.count_ = header.count;
+        snapshot.storage_ = std::move(owner);
+        return snapshot;
+    }
+
+    env_diff env_snapshot::diff(const env_snapshot& before,
+                                const env_snapshot& after)
+    {
+        env_diff result;
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < before.count_ || j < after.count_)
+        {
+            if (j == after.count_)
+            {
+                result.removed.emplace_back(before.key_of(before.entries_[i++]));
+                continue;
+            }
+            if (i == before.count_)
+            {
+                result.added.emplace_back(after.key_of(after.entries_[j++]));
+                continue;
+            }
+
+            const auto old_key = before.key_of(before.entries_[i]);
+            const auto new_key = after.key_of(after.entries_[j]);
+            if (old_key < new_key)
+            {
+                result.removed.emplace_back(old_key);
+                ++i;
+            }
+            else if (new_key < old_key)
+            {
+                result.added.emplace_back(new_key);
+                ++j;
+            }
+            else
+            {
+                if (before.value_of(before.entries_[i]) !=
+                    after.value_of(after.entries_[j]))
+                {
+                    result.changed.emplace_back(new_key);
+                }
+                ++i;
+                ++j;
+            }
+        }
+        return result;
+    }
+} // namespace dot_env
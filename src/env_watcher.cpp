@@ -0,0 +1,581 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "../include/env_watcher.hpp"
+
+#include "../include/env.hpp"
+#include "file_buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define DOT_ENV_WATCH_WIN32 1
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define DOT_ENV_WATCH_INOTIFY 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) ||     \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+#include <fcntl.h>
+#include <sys/event.h>
+#include <unistd.h>
+#define DOT_ENV_WATCH_KQUEUE 1
+#endif
+
+namespace dot_env
+{
+    /**
+     * Platform notification state. wait() blocks until something happened
+     * to the watched file (true) or wake() was called (false).
+     */
+    struct env_watcher::native_watch
+    {
+        native_watch(const std::filesystem::path& file);
+        ~native_watch();
+
+        native_watch(const native_watch&) = delete;
+        native_watch& operator=(const native_watch&) = delete;
+
+        bool wait();
+        void wake();
+
+        std::filesystem::path directory;
+        std::filesystem::path filename;
+
+#if defined(DOT_ENV_WATCH_INOTIFY)
+        bool watch_directory() const;
+
+        int inotify_fd = -1;
+        int wake_fd = -1;
+#elif defined(DOT_ENV_WATCH_KQUEUE)
+        void watch_file();
+
+        int queue = -1;
+        int directory_fd = -1;
+        int file_fd = -1;
+#elif defined(DOT_ENV_WATCH_WIN32)
+        HANDLE directory_handle = INVALID_HANDLE_VALUE;
+        HANDLE change_event = nullptr;
+        HANDLE stop_event = nullptr;
+        OVERLAPPED overlapped{};
+        alignas(DWORD) std::array<std::byte, 16 * 1024> buffer{};
+#endif
+    };
+
+    namespace
+    {
+        [[noreturn]] void throw_last_error(const char* what)
+        {
+#ifdef _WIN32
+            throw std::system_error(static_cast<int>(GetLastError()),
+                                    std::system_category(), what);
+#else
+            throw std::system_error(errno, std::generic_category(), what);
+#endif
+        }
+    } // namespace
+
+#if defined(DOT_ENV_WATCH_INOTIFY)
+    env_watcher::native_watch::native_watch(const std::filesystem::path& file) :
+        directory(file.parent_path()), filename(file.filename())
+    {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0)
+            throw_last_error("inotify_init1");
+
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd < 0)
+        {
+            const int error = errno;
+            close(inotify_fd);
+            throw std::system_error(error, std::generic_category(), "eventfd");
+        }
+
+        if (!watch_directory())
+        {
+            const int error = errno;
+            close(wake_fd);
+            close(inotify_fd);
+            throw std::system_error(error, std::generic_category(),
+                                    "inotify_add_watch");
+        }
+    }
+
+    env_watcher::native_watch::~native_watch()
+    {
+        close(wake_fd);
+        close(inotify_fd);
+    }
+
+    bool env_watcher::native_watch::watch_directory() const
+    {
+        // Watch the directory: editors often replace the file by rename
+        constexpr std::uint32_t mask =
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF;
+        return inotify_add_watch(inotify_fd, directory.c_str(), mask) >= 0;
+    }
+
+    bool env_watcher::native_watch::wait()
+    {
+        alignas(inotify_event) std::array<char, 4096> events{};
+        for (;;)
+        {
+            std::array<pollfd, 2> fds{{{inotify_fd, POLLIN, 0},
+                                       {wake_fd, POLLIN, 0}}};
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            if (fds[1].revents != 0)
+                return false;
+
+            bool relevant = false;
+            bool watch_lost = false;
+            ssize_t length = 0;
+            while ((length = read(inotify_fd, events.data(), events.size())) >
+                   0)
+            {
+                for (const char* p = events.data(); p < events.data() + length;)
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(p);
+                    if ((event->mask & IN_Q_OVERFLOW) != 0)
+                    {
+                        // Events were dropped; re-check to be safe
+                        relevant = true;
+                    }
+                    else if ((event->mask & (IN_DELETE_SELF | IN_IGNORED)) != 0)
+                    {
+                        // The directory went away and took the watch with it
+                        relevant = true;
+                        watch_lost = true;
+                    }
+                    else if (event->len > 0 && filename == event->name)
+                    {
+                        relevant = true;
+                    }
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+
+            // Re-arm in case the directory was recreated already; if not,
+            // refresh() keeps serving the current values
+            if (watch_lost)
+                watch_directory();
+
+            if (relevant)
+                return true;
+        }
+    }
+
+    void env_watcher::native_watch::wake()
+    {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto written = write(wake_fd, &one, sizeof(one));
+    }
+#elif defined(DOT_ENV_WATCH_KQUEUE)
+    env_watcher::native_watch::native_watch(const std::filesystem::path& file) :
+        directory(file.parent_path()), filename(file.filename())
+    {
+        queue = kqueue();
+        if (queue < 0)
+            throw_last_error("kqueue");
+
+        directory_fd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+        if (directory_fd < 0)
+        {
+            const int error = errno;
+            close(queue);
+            throw std::system_error(error, std::generic_category(), "open");
+        }
+
+        std::array<struct kevent, 2> changes{};
+        // Directory writes cover files being created or renamed into place
+        EV_SET(&changes[0], directory_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+               NOTE_WRITE, 0, nullptr);
+        EV_SET(&changes[1], 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+        if (kevent(queue, changes.data(), static_cast<int>(changes.size()),
+                   nullptr, 0, nullptr) < 0)
+        {
+            const int error = errno;
+            close(directory_fd);
+            close(queue);
+            throw std::system_error(error, std::generic_category(), "kevent");
+        }
+
+        watch_file();
+    }
+
+    env_watcher::native_watch::~native_watch()
+    {
+        if (file_fd >= 0)
+            close(file_fd);
+        close(directory_fd);
+        close(queue);
+    }
+
+    void env_watcher::native_watch::watch_file()
+    {
+        // In-place writes only show up on the file itself. The descriptor
+        // follows the inode, so it is reopened after every event.
+        if (file_fd >= 0)
+            close(file_fd);
+
+        file_fd = open((directory / filename).c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_fd < 0)
+            return;
+
+        struct kevent change{};
+        EV_SET(&change, file_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+               NOTE_WRITE | NOTE_EXTEND | NOTE_DELETE | NOTE_RENAME, 0,
+               nullptr);
+        kevent(queue, &change, 1, nullptr, 0, nullptr);
+    }
+
+    bool env_watcher::native_watch::wait()
+    {
+        for (;;)
+        {
+            struct kevent event{};
+            const int count = kevent(queue, nullptr, 0, &event, 1, nullptr);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            if (count == 0)
+                continue;
+
+            if (event.filter == EVFILT_USER)
+                return false;
+
+            watch_file();
+            return true;
+        }
+    }
+
+    void env_watcher::native_watch::wake()
+    {
+        struct kevent trigger{};
+        EV_SET(&trigger, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+        kevent(queue, &trigger, 1, nullptr, 0, nullptr);
+    }
+#elif defined(DOT_ENV_WATCH_WIN32)
+    env_watcher::native_watch::native_watch(const std::filesystem::path& file) :
+        directory(file.parent_path()), filename(file.filename())
+    {
+        directory_handle = CreateFileW(
+            directory.c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            nullptr);
+        if (directory_handle == INVALID_HANDLE_VALUE)
+            throw_last_error("CreateFileW");
+
+        change_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (change_event == nullptr || stop_event == nullptr)
+        {
+            const auto error = GetLastError();
+            if (change_event)
+                CloseHandle(change_event);
+            if (stop_event)
+                CloseHandle(stop_event);
+            CloseHandle(directory_handle);
+            throw std::system_error(static_cast<int>(error),
+                                    std::system_category(), "CreateEventW");
+        }
+    }
+
+    env_watcher::native_watch::~native_watch()
+    {
+        CancelIoEx(directory_handle, &overlapped);
+        CloseHandle(directory_handle);
+        CloseHandle(change_event);
+        CloseHandle(stop_event);
+    }
+
+    bool env_watcher::native_watch::wait()
+    {
+        for (;;)
+        {
+            overlapped = {};
+            overlapped.hEvent = change_event;
+            ResetEvent(change_event);
+
+            constexpr DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE |
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+            if (!ReadDirectoryChangesW(directory_handle, buffer.data(),
+                                       static_cast<DWORD>(buffer.size()),
+                                       FALSE, filter, nullptr, &overlapped,
+                                       nullptr))
+            {
+                return false;
+            }
+
+            const std::array<HANDLE, 2> handles{change_event, stop_event};
+            const DWORD signaled =
+                WaitForMultipleObjects(static_cast<DWORD>(handles.size()),
+                                       handles.data(), FALSE, INFINITE);
+            if (signaled != WAIT_OBJECT_0)
+            {
+                CancelIoEx(directory_handle, &overlapped);
+                return false;
+            }
+
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(directory_handle, &overlapped, &bytes,
+                                     FALSE))
+            {
+                return false;
+            }
+
+            // An overflowed buffer reports zero bytes; re-check to be safe
+            if (bytes == 0)
+                return true;
+
+            bool relevant = false;
+            for (const std::byte* p = buffer.data();;)
+            {
+                const auto* info =
+                    reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                const std::wstring_view name(
+                    info->FileName, info->FileNameLength / sizeof(WCHAR));
+                if (_wcsnicmp(name.data(), filename.c_str(), name.size()) ==
+                        0 &&
+                    filename.native().size() == name.size())
+                {
+                    relevant = true;
+                }
+
+                if (info->NextEntryOffset == 0)
+                    break;
+                p += info->NextEntryOffset;
+            }
+
+            if (relevant)
+                return true;
+        }
+    }
+
+    void env_watcher::native_watch::wake() { SetEvent(stop_event); }
+#else
+    env_watcher::native_watch::native_watch(const std::filesystem::path& file) :
+        directory(file.parent_path()), filename(file.filename())
+    {
+        throw std::system_error(
+            std::make_error_code(std::errc::function_not_supported),
+            "env_watcher has no notification backend on this platform");
+    }
+
+    env_watcher::native_watch::~native_watch() = default;
+
+    bool env_watcher::native_watch::wait() { return false; }
+
+    void env_watcher::native_watch::wake() {}
+#endif
+
+    env_watcher::env_watcher(concurrent_env& target) :
+        env_watcher(target, target.source_path())
+    {
+    }
+
+    env_watcher::env_watcher(concurrent_env& target,
+                             std::filesystem::path path) :
+        target_(target), path_(std::move(path))
+    {
+        if (path_.empty())
+            throw std::invalid_argument(
+                "env_watcher needs a file; load one into the target first");
+
+        path_ = std::filesystem::absolute(path_);
+    }
+
+    env_watcher::~env_watcher() { stop(); }
+
+    void env_watcher::start()
+    {
+        if (thread_.joinable())
+            return;
+
+        if (target_.source_layers() > 1)
+            throw std::invalid_argument(
+                "env_watcher reloads one file, but the target merged several layers");
+
+        native_ = std::make_unique<native_watch>(path_);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void env_watcher::stop()
+    {
+        if (!thread_.joinable())
+            return;
+
+        native_->wake();
+        thread_.join();
+        native_.reset();
+    }
+
+    void env_watcher::run()
+    {
+        // The file may have changed between the target's load and the
+        // watch being set up; no event is coming for that edit
+        refresh();
+        while (native_->wait())
+        {
+            refresh();
+        }
+    }
+
+    bool env_watcher::refresh()
+    {
+        {
+            const std::scoped_lock lock(refresh_mutex_);
+
+            // Publishing one file would drop the target's other layers
+            if (target_.source_layers() > 1)
+                return false;
+
+            const auto file = detail::file_buffer::open(path_);
+            if (!file.has_value())
+            {
+                // Missing or mid-replace; keep serving the current values
+                return false;
+            }
+
+            const auto hash = detail::hash_key(file->view());
+            if (content_hash_ == hash)
+                return false;
+
+            env loader;
+            loader.set_injection(injection_mode::deferred);
+            loader.parse_env_buffer(file->view(), false);
+            auto next = loader.freeze();
+
+            const auto previous = target_.publish(next);
+            content_hash_ = hash;
+
+            auto diff = env_snapshot::diff(*previous, next);
+            if (!diff.empty())
+                pending_.push_back({std::move(diff), std::move(next)});
+
+            // A refresh that is already dispatching, possibly our own caller
+            // further up the stack, delivers this reload after its own
+            if (dispatching_)
+                return true;
+            dispatching_ = true;
+        }
+
+        dispatch_pending();
+        return true;
+    }
+
+    void env_watcher::dispatch_pending()
+    {
+        // Callbacks run without refresh_mutex_ so they may call refresh()
+        // themselves; reloads queued meanwhile are delivered in order
+        for (;;)
+        {
+            pending_reload reload;
+            {
+                const std::scoped_lock lock(refresh_mutex_);
+                if (pending_.empty())
+                {
+                    dispatching_ = false;
+                    return;
+                }
+                reload = std::move(pending_.front());
+                pending_.pop_front();
+            }
+
+            try
+            {
+                notify(reload.diff, reload.current);
+            }
+            catch (...)
+            {
+                // Leave the rest queued for the next refresh to deliver
+                const std::scoped_lock lock(refresh_mutex_);
+                dispatching_ = false;
+                throw;
+            }
+        }
+    }
+
+    void env_watcher::notify(const env_diff& diff, const env_snapshot& current)
+    {
+        // Callbacks run on copies, without the lock, so they may subscribe
+        // and unsubscribe on this watcher
+        std::vector<reload_subscriber> reload_subscribers;
+        std::vector<key_subscriber> key_subscribers;
+        {
+            const std::scoped_lock lock(subscribers_mutex_);
+            reload_subscribers = reload_subscribers_;
+            key_subscribers = key_subscribers_;
+        }
+
+        for (const auto& subscriber : reload_subscribers)
+            subscriber.callback(diff, current);
+
+        if (key_subscribers.empty())
+            return;
+
+        const auto dispatch = [&](const std::vector<std::string>& keys)
+        {
+            for (const auto& key : keys)
+            {
+                for (const auto& subscriber : key_subscribers)
+                {
+                    if (subscriber.key == key)
+                        subscriber.callback(key, current.get_view(key));
+                }
+            }
+        };
+        dispatch(diff.added);
+        dispatch(diff.changed);
+        dispatch(diff.removed);
+    }
+
+    env_watcher::subscription env_watcher::on_change(const std::string_view key,
+                                                     key_callback callback)
+    {
+        const std::scoped_lock lock(subscribers_mutex_);
+        const auto id = next_id_++;
+        key_subscribers_.push_back({id, std::string(key), std::move(callback)});
+        return id;
+    }
+
+    env_watcher::subscription env_watcher::on_reload(reload_callback callback)
+    {
+        const std::scoped_lock lock(subscribers_mutex_);
+        const auto id = next_id_++;
+        reload_subscribers_.push_back({id, std::move(callback)});
+        return id;
+    }
+
+    void env_watcher::unsubscribe(const subscription id)
+    {
+        const std::scoped_lock lock(subscribers_mutex_);
+        std::erase_if(key_subscribers_,
+                      [id](const key_subscriber& s) { return s.id == id; });
+        std::erase_if(reload_subscribers_,
+                      [id](const reload_subscriber& s) { return s.id == id; });
+    }
+} // namespace dot_env
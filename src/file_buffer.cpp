@@ -0,0 +1,204 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "file_buffer.hpp"
+
+#include <cerrno>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dot_env::detail
+{
+    file_buffer::file_buffer(file_buffer&& other) noexcept :
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        mapped_(std::exchange(other.mapped_, false)),
+#ifdef _WIN32
+        mapping_(std::exchange(other.mapping_, nullptr)),
+#endif
+        owned_(std::move(other.owned_))
+    {
+        // Moving a short string copies its characters, so re-point the view
+        if (!mapped_)
+            data_ = owned_.data();
+    }
+
+    file_buffer& file_buffer::operator=(file_buffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            mapped_ = std::exchange(other.mapped_, false);
+#ifdef _WIN32
+            mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+            owned_ = std::move(other.owned_);
+            if (!mapped_)
+                data_ = owned_.data();
+        }
+        return *this;
+    }
+
+    file_buffer::~file_buffer() { release(); }
+
+    void file_buffer::release() noexcept
+    {
+        if (mapped_)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(data_);
+            CloseHandle(static_cast<HANDLE>(mapping_));
+            mapping_ = nullptr;
+#else
+            munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        owned_.clear();
+    }
+
+#ifdef _WIN32
+    std::optional<file_buffer>
+    file_buffer::open(const std::filesystem::path& path)
+    {
+        const HANDLE file =
+            CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return std::nullopt;
+
+        file_buffer buffer;
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return std::nullopt;
+        }
+
+        if (size.QuadPart > 0)
+        {
+            const HANDLE mapping =
+                CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+            {
+                if (const void* view =
+                        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+                {
+                    buffer.data_ = static_cast<const char*>(view);
+                    buffer.size_ = static_cast<std::size_t>(size.QuadPart);
+                    buffer.mapped_ = true;
+                    buffer.mapping_ = mapping;
+                }
+                else
+                {
+                    CloseHandle(mapping);
+                }
+            }
+        }
+
+        if (!buffer.mapped_)
+        {
+            // Fall back to a plain read for empty or unmappable files
+            char chunk[64 * 1024];
+            DWORD read = 0;
+            while (ReadFile(file, chunk, sizeof(chunk), &read, nullptr) &&
+                   read > 0)
+            {
+                buffer.owned_.append(chunk, read);
+            }
+            buffer.data_ = buffer.owned_.data();
+            buffer.size_ = buffer.owned_.size();
+        }
+
+        CloseHandle(file);
+        return buffer;
+    }
+#else
+    std::optional<file_buffer>
+    file_buffer::open(const std::filesystem::path& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return std::nullopt;
+
+        file_buffer buffer;
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            if (void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                view != MAP_FAILED)
+            {
+                buffer.data_ = static_cast<const char*>(view);
+                buffer.size_ = size;
+                buffer.mapped_ = true;
+            }
+            else
+            {
+                // Size is known, so a single read usually fills the buffer
+                buffer.owned_.reserve(size);
+            }
+        }
+
+        if (!buffer.mapped_)
+        {
+            char chunk[64 * 1024];
+            ssize_t read = 0;
+            while ((read = ::read(fd, chunk, sizeof(chunk))) != 0)
+            {
+                if (read < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    ::close(fd);
+                    return std::nullopt;
+                }
+                buffer.owned_.append(chunk, static_cast<std::size_t>(read));
+            }
+            buffer.data_ = buffer.owned_.data();
+            buffer.size_ = buffer.owned_.size();
+        }
+
+        ::close(fd);
+        return buffer;
+    }
+
+    std::optional<file_buffer> file_buffer::map(const int fd)
+    {
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+            return std::nullopt;
+
+        const auto size = static_cast<std::size_t>(info.st_size);
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+            return std::nullopt;
+
+        file_buffer buffer;
+        buffer.data_ = static_cast<const char*>(view);
+        buffer.size_ = size;
+        buffer.mapped_ = true;
+        return buffer;
+    }
+#endif
+} // namespace dot_env::detail
@@ -0,0 +1,75 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_FILE_BUFFER_HPP
+#define DOT_ENV_FILE_BUFFER_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dot_env::detail
+{
+    /**
+     * Read-only view of a whole file's contents.
+     *
+     * Regular files are memory-mapped so the parser can tokenize them in
+     * place. When mapping is not possible (empty files, special files or
+     * filesystems that refuse mmap) the contents are read into an owned
+     * buffer instead, so callers always get a contiguous view either way.
+     */
+    class file_buffer
+    {
+    public:
+        file_buffer(const file_buffer&) = delete;
+        file_buffer& operator=(const file_buffer&) = delete;
+        file_buffer(file_buffer&& other) noexcept;
+        file_buffer& operator=(file_buffer&& other) noexcept;
+        ~file_buffer();
+
+        /**
+         * Opens and maps the file at the given path.
+         *
+         * @param path The file to open.
+         * @return The mapped file, or std::nullopt if it could not be
+         * opened or read.
+         */
+        [[nodiscard]] static std::optional<file_buffer>
+        open(const std::filesystem::path& path);
+
+#ifndef _WIN32
+        /**
+         * Maps the regular file behind an open descriptor, which stays open
+         * and owned by the caller.
+         *
+         * @param fd The descriptor to map.
+         * @return The mapped file, or std::nullopt if fd is not a non-empty
+         * regular file or cannot be mapped; read it as a stream instead.
+         */
+        [[nodiscard]] static std::optional<file_buffer> map(int fd);
+#endif
+
+        [[nodiscard]] std::string_view view() const noexcept
+        {
+            return {data_, size_};
+        }
+
+    private:
+        file_buffer() = default;
+
+        void release() noexcept;
+
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+        bool mapped_ = false;
+#ifdef _WIN32
+        void* mapping_ = nullptr;
+#endif
+        std::string owned_ = {};
+    };
+} // namespace dot_env::detail
+
+#endif // DOT_ENV_FILE_BUFFER_HPP
@@ -0,0 +1,117 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_INTERPOLATE_HPP
+#define DOT_ENV_INTERPOLATE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dot_env::detail
+{
+    /**
+     * One ${NAME} or ${NAME:-default} found in a value.
+     */
+    struct reference
+    {
+        // Offsets of "${" and one past the closing '}'
+        std::size_t begin;
+        std::size_t end;
+        std::string_view name;
+        std::optional<std::string_view> fallback;
+    };
+
+    [[nodiscard]] constexpr bool
+    has_references(const std::string_view text) noexcept
+    {
+        return text.find("${") != std::string_view::npos;
+    }
+
+    /**
+     * Finds the next reference at or after pos. Braces nest, so a default
+     * may itself contain references. An unterminated "${" is not a
+     * reference.
+     */
+    [[nodiscard]] constexpr std::optional<reference>
+    next_reference(const std::string_view text, std::size_t pos) noexcept
+    {
+        const std::size_t open = text.find("${", pos);
+        if (open == std::string_view::npos)
+            return std::nullopt;
+
+        std::size_t depth = 1;
+        std::size_t i = open + 2;
+        while (i < text.size() && depth > 0)
+        {
+            if (text[i] == '$' && i + 1 < text.size() && text[i + 1] == '{')
+            {
+                ++depth;
+                i += 2;
+            }
+            else
+            {
+                depth -= text[i] == '}' ? 1 : 0;
+                ++i;
+            }
+        }
+        if (depth != 0)
+            return std::nullopt;
+
+        const auto body = text.substr(open + 2, i - 1 - (open + 2));
+        const auto separator = body.find(":-");
+        reference ref{open, i, body.substr(0, separator), std::nullopt};
+        if (separator != std::string_view::npos)
+            ref.fallback = body.substr(separator + 2);
+        return ref;
+    }
+
+    /**
+     * Invokes on_name for every variable text may reference, including
+     * the ones only used inside defaults.
+     */
+    template <typename OnName>
+    void for_each_reference(const std::string_view text, OnName&& on_name)
+    {
+        std::size_t pos = 0;
+        while (const auto ref = next_reference(text, pos))
+        {
+            on_name(ref->name);
+            if (ref->fallback.has_value())
+                for_each_reference(*ref->fallback, on_name);
+            pos = ref->end;
+        }
+    }
+
+    /**
+     * Appends text to out with every reference replaced by resolve(name).
+     * A reference to an unset or empty variable expands to its default if
+     * it has one, and to nothing otherwise.
+     *
+     * @param resolve Invoked as resolve(std::string_view name) and returns
+     * std::optional<std::string_view>.
+     */
+    template <typename Resolve>
+    void expand_references(const std::string_view text, Resolve&& resolve,
+                           std::string& out)
+    {
+        std::size_t pos = 0;
+        while (const auto ref = next_reference(text, pos))
+        {
+            out.append(text.substr(pos, ref->begin - pos));
+
+            const std::optional<std::string_view> value = resolve(ref->name);
+            if (value.has_value() && !value->empty())
+                out.append(*value);
+            else if (ref->fallback.has_value())
+                expand_references(*ref->fallback, resolve, out);
+
+            pos = ref->end;
+        }
+        out.append(text.substr(pos));
+    }
+} // namespace dot_env::detail
+
+#endif // DOT_ENV_INTERPOLATE_HPP
@@ -0,0 +1,60 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dot_env::detail
+{
+    namespace
+    {
+        // Offset of the quote closing a double-quoted value whose text starts
+        // at pos, or text.size() if there is none
+        [[nodiscard]] std::size_t
+        find_closing_quote(const std::string_view text, std::size_t pos,
+                           bool& escaped) noexcept
+        {
+            constexpr delimiter_set quote_or_escape("\"\\");
+            while (pos < text.size())
+            {
+                pos = find_first_of(text, pos, quote_or_escape);
+                if (pos >= text.size() || text[pos] == '"')
+                    return pos;
+
+                // Skip the escaped character, which may be a quote
+                escaped = true;
+                pos += 2;
+            }
+            return text.size();
+        }
+    } // namespace
+
+    quoted_span scan_quoted(const std::string_view buffer,
+                            const std::size_t value_begin,
+                            const std::size_t eol) noexcept
+    {
+        const char quote = buffer[value_begin];
+        quoted_span span{0, std::min(eol + 1, buffer.size()), 0, false};
+        span.close = quote == '"'
+            ? find_closing_quote(buffer, value_begin + 1, span.escaped)
+            : std::min(buffer.find('\'', value_begin + 1), buffer.size());
+
+        // Whatever follows the closing quote on its line is ignored
+        if (span.close > eol && span.close < buffer.size())
+        {
+            span.extra_lines = static_cast<std::size_t>(
+                std::count(buffer.begin() + static_cast<std::ptrdiff_t>(eol),
+                           buffer.begin() + static_cast<std::ptrdiff_t>(span.close),
+                           '\n'));
+            const auto* newline = static_cast<const char*>(std::memchr(
+                buffer.data() + span.close, '\n', buffer.size() - span.close));
+            span.next = newline != nullptr
+                ? static_cast<std::size_t>(newline - buffer.data()) + 1
+                : buffer.size();
+        }
+        return span;
+    }
+} // namespace dot_env::detail
@@ -0,0 +1,483 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_PARSER_HPP
+#define DOT_ENV_PARSER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "scanner.hpp"
+
+namespace dot_env::detail
+{
+    /**
+     * A single KEY=VALUE assignment found by tokenize().
+     *
+     * Both views point into the buffer being tokenized; nothing is copied
+     * until the caller decides to store the entry. For a quoted value the
+     * view covers the text between the quotes, with escapes left as
+     * written; value_text() resolves them.
+     */
+    struct token
+    {
+        std::string_view key;
+        std::string_view value;
+        std::size_t line;
+        // A double-quoted value containing backslash escapes
+        bool escaped = false;
+        // A single-quoted value, which is never expanded
+        bool literal = false;
+    };
+
+    [[nodiscard]] constexpr bool is_whitespace(const char c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    /**
+     * Strips leading and trailing spaces, tabs, carriage returns and
+     * newlines. Leading/trailing whitespace is usually a byte or two, so a
+     * direct loop beats the generic find_first_not_of set search.
+     */
+    [[nodiscard]] constexpr std::string_view
+    trim(const std::string_view text) noexcept
+    {
+        std::size_t first = 0;
+        std::size_t last = text.size();
+        while (first < last && is_whitespace(text[first]))
+            ++first;
+        while (last > first && is_whitespace(text[last - 1]))
+            --last;
+
+        return text.substr(first, last - first);
+    }
+
+    /**
+     * Appends a double-quoted value to out with \n, \r, \t, \" and \\
+     * resolved, in a single pass. Any other backslash is kept as written.
+     */
+    inline void unescape(const std::string_view text, std::string& out)
+    {
+        out.reserve(out.size() + text.size());
+        std::size_t pos = 0;
+        for (std::size_t slash = text.find('\\');
+             slash != std::string_view::npos && slash + 1 < text.size();
+             slash = text.find('\\', pos))
+        {
+            out.append(text.substr(pos, slash - pos));
+            switch (const char c = text[slash + 1])
+            {
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case '"':
+            case '\\':
+                out += c;
+                break;
+            default:
+                out += '\\';
+                out += c;
+                break;
+            }
+            pos = slash + 2;
+        }
+        out.append(text.substr(pos));
+    }
+
+    /**
+     * Returns the token's value with escapes resolved. Only escaped values
+     * are rebuilt, into scratch; all others are returned as they are.
+     */
+    [[nodiscard]] inline std::string_view value_text(const token& t,
+                                                     std::string& scratch)
+    {
+        if (!t.escaped)
+            return t.value;
+
+        scratch.clear();
+        unescape(t.value, scratch);
+        return scratch;
+    }
+
+    /**
+     * One logical line as classified by for_each_line(): a single physical
+     * line, or several if a quoted value spans them.
+     */
+    struct scanned_line
+    {
+        enum class kind
+        {
+            // Blank, a comment or without '='
+            skipped,
+            assignment,
+            // Empty key or value; see line
+            invalid,
+            // A quote still open where the buffer ends, which more input
+            // may close
+            open_quote,
+        };
+
+        kind what;
+        // The assignment; its line member is left to the caller
+        token entry;
+        // The first physical line, trimmed; set for assignments and
+        // invalid lines
+        std::string_view line;
+        // Offset of the line following this one, at most buffer.size()
+        std::size_t next;
+        // Newlines inside a quoted value
+        std::size_t extra_lines;
+    };
+
+    // Marks a scanned assignment invalid if its key or value is empty
+    inline void classify(scanned_line& result) noexcept
+    {
+        result.what = result.entry.key.empty() || result.entry.value.empty()
+            ? scanned_line::kind::invalid
+            : scanned_line::kind::assignment;
+    }
+
+    /**
+     * Where a quoted value ends, as found by scan_quoted().
+     */
+    struct quoted_span
+    {
+        // Offset of the closing quote, or the buffer size if there is none
+        std::size_t close;
+        // Offset of the line following the closing quote's
+        std::size_t next;
+        std::size_t extra_lines;
+        bool escaped;
+    };
+
+    /**
+     * The slow path of for_each_line(): finds the end of a quoted value
+     * that does not simply close on its own line, because it has escapes,
+     * spans lines or is never closed. Kept out of line so the loop stays
+     * small.
+     *
+     * @param buffer The buffer.
+     * @param value_begin The offset of the opening quote.
+     * @param eol The offset of the newline ending the quote's line.
+     */
+    [[nodiscard]] quoted_span scan_quoted(std::string_view buffer,
+                                          std::size_t value_begin,
+                                          std::size_t eol) noexcept;
+
+    /**
+     * Walks the logical lines of buffer that start in [begin, end),
+     * classifying each one; see tokenize() for the syntax.
+     *
+     * @param buffer The buffer; a quoted value may extend up to its end.
+     * @param complete Whether the buffer holds the whole input. If not, a
+     * quote left open at the end stops the walk at its line instead of
+     * being kept as part of an unquoted value.
+     * @param on_line Invoked as on_line(std::size_t line_begin, const
+     * scanned_line&) for every line.
+     * @return Where the walk stopped: past end if the last value runs on
+     * beyond it, or before end at a line whose quote is still open.
+     */
+    template <typename OnLine>
+    std::size_t for_each_line(const std::string_view buffer, std::size_t begin,
+                              const std::size_t end, const bool complete,
+                              OnLine&& on_line)
+    {
+        while (begin < end)
+        {
+            const std::size_t pos = begin;
+            // Kept in the loop body rather than a function of its own, so
+            // the common case compiles into the loop
+            const scanned_line scanned = [&]
+            {
+                // One classification pass yields both the line end and its '='
+                const auto [assignment, eol] = split_line(buffer, pos);
+                scanned_line result{scanned_line::kind::skipped, {}, {},
+                                    std::min(eol + 1, buffer.size()), 0};
+                if (assignment == std::string_view::npos)
+                    return result;
+
+                const auto line = trim(buffer.substr(pos, eol - pos));
+                if (line.front() == '#')
+                    return result;
+
+                result.line = line;
+                auto key = trim(buffer.substr(pos, assignment - pos));
+                if (key.size() > 7 && key.starts_with("export") &&
+                    (key[6] == ' ' || key[6] == '\t'))
+                {
+                    key = trim(key.substr(7));
+                }
+                result.entry.key = key;
+
+                std::size_t value_begin = assignment + 1;
+                while (value_begin < eol &&
+                       (buffer[value_begin] == ' ' || buffer[value_begin] == '\t'))
+                {
+                    ++value_begin;
+                }
+
+                const char quote = value_begin < eol ? buffer[value_begin] : '\0';
+                if (quote == '"' || quote == '\'')
+                {
+                    // Most quoted values close on their own line without escapes,
+                    // which two short memchr calls settle
+                    const char* text = buffer.data() + value_begin + 1;
+                    const auto* close = static_cast<const char*>(
+                        std::memchr(text, quote, eol - value_begin - 1));
+                    if (close != nullptr &&
+                        (quote == '\'' ||
+                         std::memchr(text, '\\', static_cast<std::size_t>(close - text)) ==
+                             nullptr))
+                    {
+                        result.entry.value = {text, static_cast<std::size_t>(close - text)};
+                        result.entry.literal = quote == '\'';
+                        classify(result);
+                        return result;
+                    }
+
+                    const auto span = scan_quoted(buffer, value_begin, eol);
+                    if (span.close < buffer.size())
+                    {
+                        result.entry.value =
+                            buffer.substr(value_begin + 1, span.close - value_begin - 1);
+                        result.entry.escaped = span.escaped;
+                        result.entry.literal = quote == '\'';
+                        result.next = span.next;
+                        result.extra_lines = span.extra_lines;
+                        classify(result);
+                        return result;
+                    }
+
+                    // More input may still close it
+                    if (!complete)
+                    {
+                        result.what = scanned_line::kind::open_quote;
+                        result.next = pos;
+                        return result;
+                    }
+                }
+
+                // Unquoted: a '#' after whitespace starts a comment
+                auto value = buffer.substr(value_begin, eol - value_begin);
+                for (std::size_t hash = value.find('#'); hash != std::string_view::npos;
+                     hash = value.find('#', hash + 1))
+                {
+                    const std::size_t at = value_begin + hash;
+                    if (at > assignment + 1 && is_whitespace(buffer[at - 1]))
+                    {
+                        value = value.substr(0, hash);
+                        break;
+                    }
+                }
+                result.entry.value = trim(value);
+                classify(result);
+                return result;
+            }();
+
+            if (scanned.what == scanned_line::kind::open_quote)
+                return begin;
+
+            on_line(pos, scanned);
+            begin = scanned.next;
+        }
+        return begin;
+    }
+
+    /**
+     * Finds the offset of the line following the logical line at pos,
+     * at most buffer.size(). Only lines with a quote pay for a full scan.
+     */
+    [[nodiscard]] inline std::size_t next_line(const std::string_view buffer,
+                                               const std::size_t pos)
+    {
+        constexpr delimiter_set newline_or_quote("\n\"'");
+        const std::size_t quote = find_first_of(buffer, pos, newline_or_quote);
+        if (quote >= buffer.size() || buffer[quote] == '\n')
+            return std::min(quote + 1, buffer.size());
+
+        const auto* newline = static_cast<const char*>(
+            std::memchr(buffer.data() + quote, '\n', buffer.size() - quote));
+        const std::size_t eol = newline != nullptr
+            ? static_cast<std::size_t>(newline - buffer.data())
+            : buffer.size();
+
+        // A first quote after the '=' either opens the value or sits inside
+        // an unquoted one. Either way, a line ending in the same quote,
+        // unescaped, holds all of it
+        std::size_t last = eol - 1;
+        if (buffer[last] == '\r')
+            --last;
+        if (last > quote + 1 && buffer[last] == buffer[quote] && buffer[last - 1] != '\\' &&
+            std::memchr(buffer.data() + pos, '=', quote - pos) != nullptr)
+        {
+            return std::min(eol + 1, buffer.size());
+        }
+
+        std::size_t next = buffer.size();
+        for_each_line(buffer, pos, pos + 1, true,
+                      [&](std::size_t, const scanned_line& scanned)
+                      { next = scanned.next; });
+        return next;
+    }
+
+    /**
+     * Tokenizes the entries of buffer that start in [begin, end), in a
+     * single pass. See tokenize() for the syntax and for_each_line() for
+     * the arguments and result.
+     */
+    template <typename OnToken, typename OnInvalid>
+    std::size_t tokenize_range(const std::string_view buffer, const std::size_t begin,
+                               const std::size_t end, const bool complete,
+                               OnToken&& on_token, OnInvalid&& on_invalid)
+    {
+        std::size_t line_number = 0;
+        return for_each_line(
+            buffer, begin, end, complete,
+            [&](std::size_t, const scanned_line& scanned)
+            {
+                ++line_number;
+                if (scanned.what == scanned_line::kind::assignment)
+                {
+                    token entry = scanned.entry;
+                    entry.line = line_number;
+                    on_token(entry);
+                }
+                else if (scanned.what == scanned_line::kind::invalid)
+                {
+                    on_invalid(scanned.line, line_number);
+                }
+                line_number += scanned.extra_lines;
+            });
+    }
+
+    /**
+     * Splits an in-memory .env buffer into assignments in a single pass.
+     *
+     * Lines are trimmed, blank lines and lines starting with '#' are
+     * skipped, and lines without '=' are ignored. An "export " before the
+     * key is dropped. Values come in three forms:
+     * - unquoted, ending at the line end or at a '#' following whitespace,
+     *   which starts a comment;
+     * - double-quoted, which may span lines and contain \n, \r, \t, \"
+     *   and \\ escapes;
+     * - single-quoted, which may span lines and are taken literally.
+     *
+     * Anything after a closing quote on its line is ignored, and a quote
+     * that is never closed stays part of an unquoted value. Lines whose key
+     * or value ends up empty are reported through on_invalid instead.
+     *
+     * @param buffer The complete file contents.
+     * @param on_token Invoked as on_token(const token&) for each assignment,
+     * in file order.
+     * @param on_invalid Invoked as on_invalid(std::string_view line,
+     * std::size_t line_number) for each rejected line.
+     */
+    template <typename OnToken, typename OnInvalid>
+    void tokenize(const std::string_view buffer, OnToken&& on_token,
+                  OnInvalid&& on_invalid)
+    {
+        tokenize_range(buffer, 0, buffer.size(), true, on_token, on_invalid);
+    }
+
+    /**
+     * The tokens and rejected lines of one slice of a buffer.
+     */
+    struct parsed_slice
+    {
+        std::vector<token> tokens;
+        std::vector<std::string_view> invalid_lines;
+        // Where tokenizing the slice stopped, see tokenize_range()
+        std::size_t end = 0;
+    };
+
+    /**
+     * Tokenizes a buffer on several threads.
+     *
+     * The buffer is cut into slice_count slices of roughly equal size, each
+     * ending just after a newline. The calling thread tokenizes the first
+     * slice while one thread per remaining slice handles the rest. A cut
+     * can still land inside a multiline quoted value; the slice before it
+     * then reads on past the cut, and the slice after it is tokenized
+     * again from where that one stopped. Replaying the slices in order
+     * yields exactly the tokens a serial tokenize() reports, so last-wins
+     * duplicate handling is unaffected; only line numbers restart at every
+     * slice.
+     *
+     * @param buffer The complete file contents.
+     * @param slice_count The number of slices, at least 1.
+     * @return The slices in buffer order; fewer than slice_count if the
+     * buffer has too few lines.
+     */
+    [[nodiscard]] inline std::vector<parsed_slice>
+    tokenize_parallel(const std::string_view buffer, const std::size_t slice_count)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        std::size_t start = 0;
+        for (std::size_t i = 1; i <= slice_count && start < buffer.size(); ++i)
+        {
+            std::size_t end = i == slice_count
+                ? buffer.size()
+                : std::max(start, buffer.size() / slice_count * i);
+            if (end < buffer.size())
+            {
+                const auto* newline = static_cast<const char*>(
+                    std::memchr(buffer.data() + end, '\n', buffer.size() - end));
+                end = newline != nullptr
+                    ? static_cast<std::size_t>(newline - buffer.data()) + 1
+                    : buffer.size();
+            }
+            ranges.emplace_back(start, end);
+            start = end;
+        }
+
+        std::vector<parsed_slice> slices(ranges.size());
+        const auto run = [&](const std::size_t i, const std::size_t begin)
+        {
+            slices[i].end = tokenize_range(
+                buffer, begin, ranges[i].second, true,
+                [&](const token& t) { slices[i].tokens.push_back(t); },
+                [&](const std::string_view line, std::size_t)
+                { slices[i].invalid_lines.push_back(line); });
+        };
+
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(ranges.size());
+            for (std::size_t i = 1; i < ranges.size(); ++i)
+                workers.emplace_back(run, i, ranges[i].first);
+            if (!ranges.empty())
+                run(0, 0);
+        }
+
+        // A slice that started inside the previous slice's last value saw
+        // the wrong lines; redo it from where that value really ended
+        for (std::size_t i = 1; i < slices.size(); ++i)
+        {
+            const std::size_t begin = slices[i - 1].end;
+            if (begin == ranges[i].first)
+                continue;
+
+            slices[i] = {};
+            if (begin < ranges[i].second)
+                run(i, begin);
+            else
+                slices[i].end = begin;
+        }
+        return slices;
+    }
+} // namespace dot_env::detail
+
+#endif // DOT_ENV_PARSER_HPP
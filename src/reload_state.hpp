@@ -0,0 +1,121 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_RELOAD_STATE_HPP
+#define DOT_ENV_RELOAD_STATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/env_key.hpp"
+#include "parser.hpp"
+
+namespace dot_env::detail
+{
+    /**
+     * A run of whole lines in a buffer, identified by a hash of its lines.
+     * A quoted value spanning several lines counts as one line, so a chunk
+     * can always be tokenized on its own.
+     */
+    struct chunk
+    {
+        std::size_t offset;
+        std::size_t length;
+        std::uint64_t hash;
+    };
+
+    /**
+     * Splits a buffer into content-defined chunks of whole lines.
+     *
+     * A chunk ends after any line whose own hash has its low bits clear
+     * (on average every 64 lines), or after 1024 lines at most. Because the
+     * boundaries depend on line contents rather than positions, inserting
+     * or deleting lines only changes the chunks around the edit; every
+     * chunk before and after it hashes exactly as it did before.
+     *
+     * @param buffer The complete file contents.
+     * @return The chunks in buffer order, covering every byte.
+     */
+    [[nodiscard]] inline std::vector<chunk>
+    split_chunks(const std::string_view buffer)
+    {
+        constexpr std::uint64_t boundary_mask = 63;
+        constexpr std::size_t max_lines = 1024;
+        constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+
+        std::vector<chunk> chunks;
+        std::size_t start = 0;
+        std::size_t lines = 0;
+        std::uint64_t hash = 0;
+        std::size_t pos = 0;
+        while (pos < buffer.size())
+        {
+            const std::size_t next = next_line(buffer, pos);
+            const std::size_t eol =
+                buffer[next - 1] == '\n' ? next - 1 : next;
+
+            const std::uint64_t line_hash =
+                hash_key(buffer.substr(pos, eol - pos));
+            hash = (hash ^ line_hash) * multiplier;
+            pos = next;
+            ++lines;
+
+            if ((line_hash & boundary_mask) == 0 || lines == max_lines ||
+                pos >= buffer.size())
+            {
+                chunks.push_back({start, pos - start, hash});
+                start = pos;
+                hash = 0;
+                lines = 0;
+            }
+        }
+        return chunks;
+    }
+
+    /**
+     * What env remembers about the last file it parsed, so a reload can
+     * tell which chunks changed without keeping the old contents around.
+     * For every chunk it stores the hash, the length and the keys the chunk
+     * assigned, in order. Keys live in one string pool.
+     */
+    struct reload_state
+    {
+        struct block
+        {
+            std::uint64_t hash;
+            std::size_t length;
+            std::size_t first_key;
+            std::size_t key_count;
+        };
+
+        std::vector<block> blocks;
+        // (offset, length) into pool
+        std::vector<std::pair<std::size_t, std::size_t>> keys;
+        std::string pool;
+
+        [[nodiscard]] std::string_view key(const std::size_t index) const
+        {
+            const auto [offset, length] = keys[index];
+            return std::string_view(pool).substr(offset, length);
+        }
+
+        void add_key(const std::string_view key)
+        {
+            keys.emplace_back(pool.size(), key.size());
+            pool.append(key);
+            ++blocks.back().key_count;
+        }
+
+        void add_block(const chunk& c)
+        {
+            blocks.push_back({c.hash, c.length, keys.size(), 0});
+        }
+    };
+} // namespace dot_env::detail
+
+#endif // DOT_ENV_RELOAD_STATE_HPP
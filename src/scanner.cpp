@@ -0,0 +1,413 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include "scanner.hpp"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) ||                                  \
+    (defined(__i386__) && defined(__SSE2__)) ||                                \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DOT_ENV_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define DOT_ENV_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that opt in;
+// MSVC accepts the intrinsics anywhere.
+#if defined(DOT_ENV_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DOT_ENV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DOT_ENV_TARGET_AVX2
+#endif
+
+namespace dot_env::detail
+{
+    namespace
+    {
+        using scan_fn = std::size_t (*)(const char*, std::size_t, std::size_t,
+                                        const delimiter_set&) noexcept;
+
+        std::size_t scan_scalar(const char* data, std::size_t pos,
+                                const std::size_t size,
+                                const delimiter_set& set) noexcept
+        {
+            const auto [a, b, c, d] = set.bytes;
+            for (; pos < size; ++pos)
+            {
+                const auto byte = static_cast<unsigned char>(data[pos]);
+                if (byte == a || byte == b || byte == c || byte == d)
+                    return pos;
+            }
+            return size;
+        }
+
+        using split_fn = line_split (*)(const char*, std::size_t,
+                                        std::size_t) noexcept;
+
+        constexpr std::size_t no_assignment = std::string_view::npos;
+
+        line_split split_scalar(const char* data, std::size_t pos,
+                                const std::size_t size,
+                                std::size_t assignment = no_assignment) noexcept
+        {
+            for (; pos < size; ++pos)
+            {
+                if (data[pos] == '\n')
+                    return {assignment, pos};
+                if (data[pos] == '=' && assignment == no_assignment)
+                    assignment = pos;
+            }
+            return {assignment, size};
+        }
+
+        /**
+         * Folds the newline and '=' masks of one block into the running
+         * split. Masks carry `scale` bits per input byte. Returns true once
+         * the newline (and therefore the whole line) has been found.
+         */
+        template <typename Mask>
+        bool resolve_block(const Mask newlines, Mask assignments,
+                           const std::size_t base, const unsigned scale,
+                           line_split& split) noexcept
+        {
+            if (newlines != 0)
+            {
+                // Only an '=' before the newline belongs to this line
+                assignments &= (newlines & (Mask{0} - newlines)) - 1;
+            }
+
+            if (split.assignment == no_assignment && assignments != 0)
+                split.assignment = base + std::countr_zero(assignments) / scale;
+
+            if (newlines == 0)
+                return false;
+
+            split.end = base + std::countr_zero(newlines) / scale;
+            return true;
+        }
+
+#ifdef DOT_ENV_SCAN_X86
+        std::size_t scan_sse2(const char* data, std::size_t pos,
+                              const std::size_t size,
+                              const delimiter_set& set) noexcept
+        {
+            const __m128i a = _mm_set1_epi8(static_cast<char>(set.bytes[0]));
+            const __m128i b = _mm_set1_epi8(static_cast<char>(set.bytes[1]));
+            const __m128i c = _mm_set1_epi8(static_cast<char>(set.bytes[2]));
+            const __m128i d = _mm_set1_epi8(static_cast<char>(set.bytes[3]));
+
+            for (; pos + 16 <= size; pos += 16)
+            {
+                const __m128i chunk = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(data + pos));
+                const __m128i hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, a),
+                                 _mm_cmpeq_epi8(chunk, b)),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, c),
+                                 _mm_cmpeq_epi8(chunk, d)));
+                if (const auto mask =
+                        static_cast<std::uint32_t>(_mm_movemask_epi8(hits)))
+                {
+                    return pos + std::countr_zero(mask);
+                }
+            }
+
+            return scan_scalar(data, pos, size, set);
+        }
+
+        line_split split_sse2(const char* data, std::size_t pos,
+                              const std::size_t size) noexcept
+        {
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i equals = _mm_set1_epi8('=');
+
+            line_split split{no_assignment, size};
+            for (; pos + 16 <= size; pos += 16)
+            {
+                const __m128i chunk = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(data + pos));
+                const auto newlines = static_cast<std::uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+                const auto assignments = static_cast<std::uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, equals)));
+                if (resolve_block(newlines, assignments, pos, 1, split))
+                    return split;
+            }
+
+            return split_scalar(data, pos, size, split.assignment);
+        }
+
+        DOT_ENV_TARGET_AVX2 std::size_t
+        scan_avx2(const char* data, std::size_t pos, const std::size_t size,
+                  const delimiter_set& set) noexcept
+        {
+            const __m256i a = _mm256_set1_epi8(static_cast<char>(set.bytes[0]));
+            const __m256i b = _mm256_set1_epi8(static_cast<char>(set.bytes[1]));
+            const __m256i c = _mm256_set1_epi8(static_cast<char>(set.bytes[2]));
+            const __m256i d = _mm256_set1_epi8(static_cast<char>(set.bytes[3]));
+
+            for (; pos + 32 <= size; pos += 32)
+            {
+                const __m256i chunk = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(data + pos));
+                const __m256i hits = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, a),
+                                    _mm256_cmpeq_epi8(chunk, b)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, c),
+                                    _mm256_cmpeq_epi8(chunk, d)));
+                if (const auto mask = static_cast<std::uint32_t>(
+                        _mm256_movemask_epi8(hits)))
+                {
+                    return pos + std::countr_zero(mask);
+                }
+            }
+
+            return scan_sse2(data, pos, size, set);
+        }
+
+        DOT_ENV_TARGET_AVX2 line_split
+        split_avx2(const char* data, std::size_t pos,
+                   const std::size_t size) noexcept
+        {
+            const __m256i newline = _mm256_set1_epi8('\n');
+            const __m256i equals = _mm256_set1_epi8('=');
+
+            line_split split{no_assignment, size};
+            for (; pos + 32 <= size; pos += 32)
+            {
+                const __m256i chunk = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(data + pos));
+                const auto newlines = static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+                const auto assignments = static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, equals)));
+                if (resolve_block(newlines, assignments, pos, 1, split))
+                    return split;
+            }
+
+            return split_scalar(data, pos, size, split.assignment);
+        }
+
+        bool cpu_has_avx2() noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4] = {};
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // AVX2 needs OSXSAVE plus OS-enabled YMM state, then leaf 7 EBX
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+#ifdef DOT_ENV_SCAN_NEON
+        // Narrows each byte lane to a nibble, giving a 64-bit mask with four
+        // bits per input byte
+        std::uint64_t neon_mask(const uint8x16_t hits) noexcept
+        {
+            return vget_lane_u64(
+                vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)),
+                0);
+        }
+
+        std::size_t scan_neon(const char* data, std::size_t pos,
+                              const std::size_t size,
+                              const delimiter_set& set) noexcept
+        {
+            const uint8x16_t a = vdupq_n_u8(set.bytes[0]);
+            const uint8x16_t b = vdupq_n_u8(set.bytes[1]);
+            const uint8x16_t c = vdupq_n_u8(set.bytes[2]);
+            const uint8x16_t d = vdupq_n_u8(set.bytes[3]);
+
+            for (; pos + 16 <= size; pos += 16)
+            {
+                const uint8x16_t chunk =
+                    vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + pos));
+                const uint8x16_t hits =
+                    vorrq_u8(vorrq_u8(vceqq_u8(chunk, a), vceqq_u8(chunk, b)),
+                             vorrq_u8(vceqq_u8(chunk, c), vceqq_u8(chunk, d)));
+                if (const std::uint64_t mask = neon_mask(hits); mask != 0)
+                    return pos + std::countr_zero(mask) / 4;
+            }
+
+            return scan_scalar(data, pos, size, set);
+        }
+
+        line_split split_neon(const char* data, std::size_t pos,
+                              const std::size_t size) noexcept
+        {
+            const uint8x16_t newline = vdupq_n_u8('\n');
+            const uint8x16_t equals = vdupq_n_u8('=');
+
+            line_split split{no_assignment, size};
+            for (; pos + 16 <= size; pos += 16)
+            {
+                const uint8x16_t chunk =
+                    vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + pos));
+                if (resolve_block(neon_mask(vceqq_u8(chunk, newline)),
+                                  neon_mask(vceqq_u8(chunk, equals)), pos, 4,
+                                  split))
+                    return split;
+            }
+
+            return split_scalar(data, pos, size, split.assignment);
+        }
+#endif
+
+        line_split split_scalar_fn(const char* data, const std::size_t pos,
+                                   const std::size_t size) noexcept
+        {
+            return split_scalar(data, pos, size);
+        }
+
+        split_fn backend_split_fn(const scan_backend backend) noexcept
+        {
+            switch (backend)
+            {
+#ifdef DOT_ENV_SCAN_X86
+            case scan_backend::sse2:
+                return split_sse2;
+            case scan_backend::avx2:
+                return split_avx2;
+#endif
+#ifdef DOT_ENV_SCAN_NEON
+            case scan_backend::neon:
+                return split_neon;
+#endif
+            default:
+                return split_scalar_fn;
+            }
+        }
+
+        scan_fn backend_fn(const scan_backend backend) noexcept
+        {
+            switch (backend)
+            {
+#ifdef DOT_ENV_SCAN_X86
+            case scan_backend::sse2:
+                return scan_sse2;
+            case scan_backend::avx2:
+                return scan_avx2;
+#endif
+#ifdef DOT_ENV_SCAN_NEON
+            case scan_backend::neon:
+                return scan_neon;
+#endif
+            default:
+                return scan_scalar;
+            }
+        }
+
+        scan_backend detect_backend() noexcept
+        {
+#if defined(DOT_ENV_SCAN_X86)
+            return cpu_has_avx2() ? scan_backend::avx2 : scan_backend::sse2;
+#elif defined(DOT_ENV_SCAN_NEON)
+            return scan_backend::neon;
+#else
+            return scan_backend::scalar;
+#endif
+        }
+
+        // Function-local statics so parsing from other static initializers
+        // never sees an unselected backend
+        scan_backend detected_backend() noexcept
+        {
+            static const scan_backend backend = detect_backend();
+            return backend;
+        }
+
+        scan_fn active_fn() noexcept
+        {
+            static const scan_fn fn = backend_fn(detected_backend());
+            return fn;
+        }
+
+        split_fn active_split_fn() noexcept
+        {
+            static const split_fn fn = backend_split_fn(detected_backend());
+            return fn;
+        }
+    } // namespace
+
+    scan_backend active_scan_backend() noexcept { return detected_backend(); }
+
+    bool scan_backend_available(const scan_backend backend) noexcept
+    {
+        switch (backend)
+        {
+        case scan_backend::scalar:
+            return true;
+#ifdef DOT_ENV_SCAN_X86
+        case scan_backend::sse2:
+            return true;
+        case scan_backend::avx2:
+            return detected_backend() == scan_backend::avx2;
+#endif
+#ifdef DOT_ENV_SCAN_NEON
+        case scan_backend::neon:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    std::size_t find_first_of(const std::string_view text,
+                              const std::size_t pos,
+                              const delimiter_set& delimiters) noexcept
+    {
+        if (pos >= text.size())
+            return text.size();
+
+        return active_fn()(text.data(), pos, text.size(), delimiters);
+    }
+
+    std::size_t find_first_of(const std::string_view text,
+                              const std::size_t pos,
+                              const delimiter_set& delimiters,
+                              const scan_backend backend) noexcept
+    {
+        if (pos >= text.size())
+            return text.size();
+
+        return backend_fn(backend)(text.data(), pos, text.size(), delimiters);
+    }
+
+    line_split split_line(const std::string_view text,
+                          const std::size_t pos) noexcept
+    {
+        if (pos >= text.size())
+            return {no_assignment, text.size()};
+
+        return active_split_fn()(text.data(), pos, text.size());
+    }
+
+    line_split split_line(const std::string_view text, const std::size_t pos,
+                          const scan_backend backend) noexcept
+    {
+        if (pos >= text.size())
+            return {no_assignment, text.size()};
+
+        return backend_split_fn(backend)(text.data(), pos, text.size());
+    }
+} // namespace dot_env::detail
@@ -0,0 +1,119 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_SCANNER_HPP
+#define DOT_ENV_SCANNER_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace dot_env::detail
+{
+    /**
+     * A set of up to four delimiter bytes searched for in one pass.
+     *
+     * Unused slots repeat the first delimiter, so the vector kernels can
+     * always compare against four lanes without special cases.
+     */
+    struct delimiter_set
+    {
+        consteval explicit delimiter_set(const std::string_view chars)
+        {
+            if (chars.empty() || chars.size() > bytes.size())
+                throw "delimiter_set holds between one and four characters";
+
+            for (std::size_t i = 0; i < bytes.size(); ++i)
+            {
+                bytes[i] = static_cast<unsigned char>(
+                    i < chars.size() ? chars[i] : chars[0]);
+            }
+        }
+
+        std::array<unsigned char, 4> bytes{};
+    };
+
+    /**
+     * Delimiter positions of one line, as found by split_line().
+     */
+    struct line_split
+    {
+        // Offset of the first '=' on the line, or npos if there is none
+        std::size_t assignment;
+        // Offset of the terminating '\n', or the buffer size on the last line
+        std::size_t end;
+    };
+
+    /**
+     * Instruction sets find_first_of() can run on. The best one supported
+     * by the running CPU is picked once, on first use.
+     */
+    enum class scan_backend
+    {
+        scalar,
+        sse2,
+        avx2,
+        neon,
+    };
+
+    /**
+     * Returns the backend find_first_of() dispatches to on this machine.
+     */
+    [[nodiscard]] scan_backend active_scan_backend() noexcept;
+
+    /**
+     * Returns whether the given backend was compiled in and is supported by
+     * the running CPU.
+     */
+    [[nodiscard]] bool scan_backend_available(scan_backend backend) noexcept;
+
+    /**
+     * Finds the first byte at or after pos that is one of the delimiters.
+     *
+     * Classifies 16 (SSE2, NEON) or 32 (AVX2) bytes per step and finishes
+     * the tail with a scalar loop.
+     *
+     * @param text The buffer to search.
+     * @param pos The offset to start searching from.
+     * @param delimiters The bytes to look for.
+     * @return The offset of the first delimiter, or text.size() if there is
+     * none.
+     */
+    [[nodiscard]] std::size_t
+    find_first_of(std::string_view text, std::size_t pos,
+                  const delimiter_set& delimiters) noexcept;
+
+    /**
+     * Classifies the line starting at pos in a single pass, locating both
+     * its first '=' and its terminating newline.
+     *
+     * The '\n' and '=' masks are computed together per 16/32-byte block so
+     * short lines are usually resolved by a single vector load.
+     *
+     * @param text The buffer to search.
+     * @param pos The offset the line starts at.
+     * @return The delimiter positions of the line.
+     */
+    [[nodiscard]] line_split split_line(std::string_view text,
+                                        std::size_t pos) noexcept;
+
+    /**
+     * Same as split_line(text, pos), but forces a specific backend.
+     * Intended for benchmarks; the backend must be available.
+     */
+    [[nodiscard]] line_split split_line(std::string_view text,
+                                        std::size_t pos,
+                                        scan_backend backend) noexcept;
+
+    /**
+     * Same as find_first_of(text, pos, delimiters), but forces a specific
+     * backend. Intended for benchmarks; the backend must be available.
+     */
+    [[nodiscard]] std::size_t
+    find_first_of(std::string_view text, std::size_t pos,
+                  const delimiter_set& delimiters,
+                  scan_backend backend) noexcept;
+} // namespace dot_env::detail
+
+#endif // DOT_ENV_SCANNER_HPP
@@ -0,0 +1,80 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "env_bind.hpp"
+#include "env_snapshot.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env::bind_issue;
+    using dot_env::field;
+    using dot_env_test::make_env;
+
+    struct server_config
+    {
+        std::string host;
+        int port = 0;
+        std::optional<long> timeout_ms;
+    };
+
+    constexpr auto server_fields = std::tuple{
+        field{"HOST", &server_config::host},
+        field{"PORT", &server_config::port},
+        field{"TIMEOUT_MS", &server_config::timeout_ms},
+    };
+
+    TEST(BindConfig, FillsEveryDescribedMember)
+    {
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("HOST=example.org\nPORT=8080\n")));
+
+        const auto config = dot_env::bind_config(environment, server_fields);
+        EXPECT_EQ(config.host, "example.org");
+        EXPECT_EQ(config.port, 8080);
+        EXPECT_FALSE(config.timeout_ms.has_value());
+    }
+
+    TEST(BindConfig, UnqualifiedCallDoesNotCollideWithStdBind)
+    {
+        // The field table is a std::tuple, so argument-dependent lookup
+        // also searches namespace std
+        using namespace std;
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("HOST=h\nPORT=1\nTIMEOUT_MS=5\n")));
+        const auto snapshot = environment.freeze();
+
+        const auto config = bind_config(snapshot, server_fields);
+        EXPECT_EQ(config.timeout_ms, 5);
+    }
+
+    TEST(BindConfig, ReportsEveryMissingOrMalformedKey)
+    {
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("PORT=eighty\n")));
+
+        server_config config;
+        const auto issues = dot_env::bind_config_into(environment, config, server_fields);
+        ASSERT_EQ(issues.size(), 2u);
+        EXPECT_EQ(issues[0].key, "HOST");
+        EXPECT_EQ(issues[0].problem, bind_issue::kind::missing);
+        EXPECT_EQ(issues[1].key, "PORT");
+        EXPECT_EQ(issues[1].problem, bind_issue::kind::malformed);
+        EXPECT_EQ(issues[1].value, "eighty");
+
+        EXPECT_THROW(static_cast<void>(dot_env::bind_config(environment, server_fields)),
+                     dot_env::bind_error);
+    }
+} // namespace
@@ -0,0 +1,157 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "concurrent_env.hpp"
+#include "env_snapshot.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env::env_snapshot;
+    using dot_env_test::make_env;
+    using dot_env_test::temp_file;
+
+    /**
+     * The conventional cache next to a source file, removed again on
+     * destruction.
+     */
+    class cache_file
+    {
+    public:
+        explicit cache_file(const temp_file& source) :
+            path_(source.path().string() + ".bin")
+        {
+        }
+
+        cache_file(const cache_file&) = delete;
+        cache_file& operator=(const cache_file&) = delete;
+
+        ~cache_file()
+        {
+            std::error_code error;
+            std::filesystem::remove(path_, error);
+        }
+
+        [[nodiscard]] const std::filesystem::path& path() const noexcept
+        {
+            return path_;
+        }
+
+        // Overwrites one byte at offset, counted from the end if negative
+        void flip_byte(const std::streamoff offset) const
+        {
+            std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekg(offset, offset < 0 ? std::ios::end : std::ios::beg);
+            char byte = 0;
+            file.read(&byte, 1);
+            file.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+            byte = static_cast<char>(byte ^ 0x5a);
+            file.write(&byte, 1);
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    [[nodiscard]] env_snapshot snapshot_of(const std::string_view contents)
+    {
+        auto environment = make_env();
+        EXPECT_TRUE(environment.load_from_buffer(contents));
+        return environment.freeze();
+    }
+
+    TEST(BinaryCache, RoundTripsEveryEntry)
+    {
+        constexpr std::string_view contents = "A=1\nB=two words\nC=\"quoted\"\n";
+        const temp_file source(contents);
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of(contents).save_cache(cache.path(), source.path()));
+
+        const auto cached = env_snapshot::open_cache(cache.path(), source.path());
+        ASSERT_TRUE(cached.has_value());
+        EXPECT_EQ(cached->size(), 3u);
+        EXPECT_EQ(cached->get_view("A"), "1");
+        EXPECT_EQ(cached->get_view("B"), "two words");
+        EXPECT_EQ(cached->get_view("C"), "quoted");
+        EXPECT_FALSE(cached->get_view("MISSING").has_value());
+    }
+
+    TEST(BinaryCache, RejectsCacheOfChangedSource)
+    {
+        const temp_file source("A=1\n");
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of("A=1\n").save_cache(cache.path(), source.path()));
+
+        source.write("A=12\n");
+        EXPECT_FALSE(env_snapshot::open_cache(cache.path(), source.path()).has_value());
+    }
+
+    TEST(BinaryCache, RejectsCorruptedPayload)
+    {
+        const temp_file source("A=1\nB=2\n");
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of("A=1\nB=2\n").save_cache(cache.path(), source.path()));
+
+        cache.flip_byte(-1);
+        EXPECT_FALSE(env_snapshot::open_cache(cache.path(), source.path()).has_value());
+    }
+
+    TEST(BinaryCache, RejectsBadMagic)
+    {
+        const temp_file source("A=1\n");
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of("A=1\n").save_cache(cache.path(), source.path()));
+
+        cache.flip_byte(0);
+        EXPECT_FALSE(env_snapshot::open_cache(cache.path(), source.path()).has_value());
+    }
+
+    TEST(BinaryCache, RejectsTruncatedCache)
+    {
+        const temp_file source("A=1\nB=2\n");
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of("A=1\nB=2\n").save_cache(cache.path(), source.path()));
+
+        const auto size = std::filesystem::file_size(cache.path());
+        for (const auto length : {std::uintmax_t{0}, std::uintmax_t{16}, size - 1})
+        {
+            std::filesystem::resize_file(cache.path(), length);
+            EXPECT_FALSE(env_snapshot::open_cache(cache.path(), source.path()).has_value())
+                << "length " << length;
+        }
+    }
+
+    // The cache below records the source's stamp but holds other values, so
+    // the result shows which one a load read
+    TEST(BinaryCache, LoadsConsultItOnlyWhenEnabled)
+    {
+        const temp_file source("A=text\n");
+        const cache_file cache(source);
+        ASSERT_TRUE(snapshot_of("A=cached\n").save_cache(cache.path(), source.path()));
+
+        dot_env::concurrent_env shared;
+        EXPECT_FALSE(shared.binary_cache());
+        ASSERT_TRUE(shared.load_env(source.name()));
+        EXPECT_EQ(shared.get("A"), "text");
+        shared.set_binary_cache(true);
+        ASSERT_TRUE(shared.load_env(source.name()));
+        EXPECT_EQ(shared.get("A"), "cached");
+
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_env(source.name()));
+        EXPECT_EQ(environment.get_view("A"), "text");
+        environment.set_binary_cache(true);
+        ASSERT_TRUE(environment.load_env(source.name()));
+        EXPECT_EQ(environment.get_view("A"), "cached");
+    }
+} // namespace
@@ -0,0 +1,125 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "env.hpp"
+#include "env_snapshot.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env::key_case;
+    using dot_env_test::temp_file;
+
+    [[nodiscard]] dot_env::env make_insensitive()
+    {
+        dot_env::env environment(key_case::insensitive);
+        environment.set_injection(dot_env::injection_mode::deferred);
+        return environment;
+    }
+
+    [[nodiscard]] unsigned char ascii_lower(const unsigned char c)
+    {
+        return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+    }
+
+    // Every byte value at every position of keys up to two words and a bit
+    // long, so each lane of the word-at-a-time fold is covered
+    TEST(CaseInsensitiveKeys, FoldMatchesAsciiLowercase)
+    {
+        for (std::size_t length = 1; length <= 19; ++length)
+        {
+            for (std::size_t pos = 0; pos < length; ++pos)
+            {
+                for (unsigned a = 0; a < 256; ++a)
+                {
+                    for (const unsigned b : {a ^ 0x20u, a ^ 0x01u, a})
+                    {
+                        std::string left(length, 'k');
+                        std::string right(length, 'K');
+                        left[pos] = static_cast<char>(a);
+                        right[pos] = static_cast<char>(b);
+
+                        const bool expected = ascii_lower(static_cast<unsigned char>(a)) ==
+                            ascii_lower(static_cast<unsigned char>(b));
+                        ASSERT_EQ(dot_env::detail::equals_case_insensitive(left, right), expected)
+                            << "length " << length << " pos " << pos << " bytes " << a << "/" << b;
+                        if (expected)
+                        {
+                            ASSERT_EQ(dot_env::detail::hash_key_folded(left),
+                                      dot_env::detail::hash_key_folded(right));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    TEST(CaseInsensitiveKeys, LookupsIgnoreAsciiCase)
+    {
+        auto environment = make_insensitive();
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("PATH=/bin\nA_LONGER_NAME_THAN_ONE_WORD=1\n\xc3\x84_UMLAUT=2\n")));
+
+        EXPECT_EQ(environment.case_policy(), key_case::insensitive);
+        EXPECT_EQ(environment.get_view("path"), "/bin");
+        EXPECT_EQ(environment.get_view("Path"), "/bin");
+        EXPECT_EQ(environment.get_view(dot_env::hashed_key("pAtH")), "/bin");
+        EXPECT_EQ(environment.get_view("a_longer_name_than_one_word"), "1");
+        EXPECT_EQ(environment.get_as<int>("A_Longer_Name_Than_One_Word"), 1);
+        EXPECT_FALSE(environment.get_view("PATH_").has_value());
+
+        // Only ASCII is folded: U+00C4 and U+00E4 stay distinct
+        EXPECT_EQ(environment.get_view("\xc3\x84_umlaut"), "2");
+        EXPECT_FALSE(environment.get_view("\xc3\xa4_umlaut").has_value());
+    }
+
+    TEST(CaseInsensitiveKeys, LaterSpellingIsADuplicate)
+    {
+        auto environment = make_insensitive();
+        ASSERT_TRUE(environment.load_from_buffer(std::string_view("Path=/a\nPATH=/b\n")));
+        EXPECT_EQ(environment.get_view("path"), "/b");
+
+        // The stored name keeps its first spelling, and snapshots match
+        // exactly
+        const auto snapshot = environment.freeze();
+        EXPECT_EQ(snapshot.size(), 1u);
+        EXPECT_EQ(snapshot.get_view("Path"), "/b");
+        EXPECT_FALSE(snapshot.get_view("PATH").has_value());
+    }
+
+    TEST(CaseInsensitiveKeys, SensitiveIsTheDefault)
+    {
+        auto environment = dot_env_test::make_env();
+        EXPECT_EQ(environment.case_policy(), key_case::sensitive);
+        ASSERT_TRUE(environment.load_from_buffer(std::string_view("Path=/a\nPATH=/b\n")));
+        EXPECT_EQ(environment.get_view("Path"), "/a");
+        EXPECT_EQ(environment.get_view("PATH"), "/b");
+        EXPECT_FALSE(environment.get_view("path").has_value());
+    }
+
+    TEST(CaseInsensitiveKeys, ReloadAndLayersFoldToo)
+    {
+        temp_file base("Key=1\nOTHER=x\n");
+        temp_file local("KEY=2\n");
+        auto environment = make_insensitive();
+        ASSERT_EQ(environment.load_layers({base.name(), local.name()}).files, 2u);
+        EXPECT_EQ(environment.get_view("key"), "2");
+
+        auto reloaded = make_insensitive();
+        ASSERT_TRUE(reloaded.load_env(base.name()));
+        base.write("KEY=3\nOTHER=x\n");
+        const auto diff = reloaded.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_TRUE(diff->added.empty());
+        EXPECT_TRUE(diff->removed.empty());
+        EXPECT_EQ(diff->changed.size(), 1u);
+        EXPECT_EQ(reloaded.get_view("kEy"), "3");
+    }
+} // namespace
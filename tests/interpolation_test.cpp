@@ -0,0 +1,147 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env::interpolation_mode;
+    using dot_env_test::make_env;
+    using dot_env_test::scoped_system_variable;
+    using dot_env_test::temp_file;
+
+    [[nodiscard]] std::vector<std::string>
+    cyclic_keys(const std::vector<dot_env::diagnostic>& diagnostics)
+    {
+        std::vector<std::string> keys;
+        for (const auto& d : diagnostics)
+        {
+            if (d.problem == dot_env::diagnostic::kind::cyclic_reference)
+                keys.push_back(d.text);
+        }
+        std::ranges::sort(keys);
+        return keys;
+    }
+
+    class Interpolation : public testing::TestWithParam<interpolation_mode>
+    {
+    };
+
+    TEST_P(Interpolation, ResolvesForwardReferencesAndDefaults)
+    {
+        auto environment = make_env(GetParam());
+        const auto result = environment.load_from_buffer(std::string_view(
+            "API_URL=${BASE_URL}/api\n"
+            "BASE_URL=http://${DOT_ENV_TEST_UNSET_HOST:-localhost}\n"
+            "NESTED=${DOT_ENV_TEST_UNSET_A:-${BASE_URL}}\n"
+            "LITERAL='${BASE_URL}'\n"));
+        ASSERT_TRUE(result);
+        EXPECT_EQ(environment.get_view("API_URL"), "http://localhost/api");
+        EXPECT_EQ(environment.get_view("NESTED"), "http://localhost");
+        EXPECT_EQ(environment.get_view("LITERAL"), "${BASE_URL}");
+        EXPECT_TRUE(cyclic_keys(result.diagnostics).empty());
+    }
+
+    TEST_P(Interpolation, SelfReferenceExtendsSystemValue)
+    {
+        const scoped_system_variable path("DOT_ENV_TEST_PATH", "/usr/bin");
+        std::vector<std::string> cyclic;
+        auto environment = make_env(GetParam());
+        environment.set_diagnostics(dot_env::severity::warning,
+                                    [&](const dot_env::diagnostic& d)
+                                    {
+                                        if (d.problem ==
+                                            dot_env::diagnostic::kind::cyclic_reference)
+                                            cyclic.push_back(d.text);
+                                    });
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("DOT_ENV_TEST_PATH=${DOT_ENV_TEST_PATH}:/opt/bin\n")));
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_PATH"), "/usr/bin:/opt/bin");
+        EXPECT_TRUE(cyclic.empty());
+    }
+
+    TEST_P(Interpolation, SelfReferenceWithoutSystemValueIsACycle)
+    {
+        std::vector<std::string> cyclic;
+        auto environment = make_env(GetParam());
+        environment.set_diagnostics(dot_env::severity::warning,
+                                    [&](const dot_env::diagnostic& d)
+                                    {
+                                        if (d.problem ==
+                                            dot_env::diagnostic::kind::cyclic_reference)
+                                            cyclic.push_back(d.text);
+                                    });
+        ASSERT_TRUE(environment.load_from_buffer(std::string_view(
+            "DOT_ENV_TEST_SELF=${DOT_ENV_TEST_SELF}:x\n"
+            "DOT_ENV_TEST_DEFAULTED=${DOT_ENV_TEST_DEFAULTED:-d}x\n")));
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_SELF"), ":x");
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_DEFAULTED"), "dx");
+        std::ranges::sort(cyclic);
+        EXPECT_EQ(cyclic, (std::vector<std::string>{"DOT_ENV_TEST_DEFAULTED",
+                                                    "DOT_ENV_TEST_SELF"}));
+    }
+
+    TEST_P(Interpolation, CycleIsBrokenOnlyAtItsMembers)
+    {
+        std::vector<std::string> cyclic;
+        auto environment = make_env(GetParam());
+        environment.set_diagnostics(dot_env::severity::warning,
+                                    [&](const dot_env::diagnostic& d)
+                                    {
+                                        if (d.problem ==
+                                            dot_env::diagnostic::kind::cyclic_reference)
+                                            cyclic.push_back(d.text);
+                                    });
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("DOT_ENV_TEST_A=x${DOT_ENV_TEST_B}y\n"
+                             "DOT_ENV_TEST_B=b${DOT_ENV_TEST_C}\n"
+                             "DOT_ENV_TEST_C=c${DOT_ENV_TEST_B}\n")));
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_A"), "xby");
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_B"), "b");
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_C"), "c");
+        std::ranges::sort(cyclic);
+        EXPECT_EQ(cyclic, (std::vector<std::string>{"DOT_ENV_TEST_B", "DOT_ENV_TEST_C"}));
+    }
+
+    TEST_P(Interpolation, ChainOfSelfReferencesIsOrderIndependent)
+    {
+        auto environment = make_env(GetParam());
+        ASSERT_TRUE(environment.load_from_buffer(
+            std::string_view("K3=${K2:-d}x\nK2=${K1:-d}x\nK1=${K1:-d}x\n")));
+        // Lazy mode expands from whichever value is read first
+        EXPECT_EQ(environment.get_view("K3"), "dxxx");
+        EXPECT_EQ(environment.get_view("K1"), "dx");
+        EXPECT_EQ(environment.get_view("K2"), "dxx");
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Modes, Interpolation,
+                             testing::Values(interpolation_mode::eager,
+                                             interpolation_mode::lazy));
+
+    TEST(InterpolationReload, InjectedSelfReferenceIsNotExtendedAgain)
+    {
+        const scoped_system_variable path("DOT_ENV_TEST_GROWING", "/usr/bin");
+        const scoped_system_variable other("DOT_ENV_TEST_OTHER", "");
+        other.unset();
+        temp_file file("DOT_ENV_TEST_GROWING=${DOT_ENV_TEST_GROWING}:/opt/bin\n"
+                       "DOT_ENV_TEST_OTHER=1\n");
+
+        dot_env::env environment;
+        environment.set_interpolation(interpolation_mode::eager);
+        ASSERT_TRUE(environment.load_env(file.name(), true));
+        EXPECT_STREQ(std::getenv("DOT_ENV_TEST_GROWING"), "/usr/bin:/opt/bin");
+
+        file.write("DOT_ENV_TEST_GROWING=${DOT_ENV_TEST_GROWING}:/opt/bin\n"
+                   "DOT_ENV_TEST_OTHER=2\n");
+        ASSERT_TRUE(environment.reload_env(true).has_value());
+        EXPECT_EQ(environment.get_view("DOT_ENV_TEST_GROWING"), "/usr/bin:/opt/bin");
+        EXPECT_STREQ(std::getenv("DOT_ENV_TEST_GROWING"), "/usr/bin:/opt/bin");
+    }
+} // namespace
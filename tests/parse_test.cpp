@@ -0,0 +1,131 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "env_snapshot.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env_test::make_env;
+    using dot_env_test::temp_file;
+
+    [[nodiscard]] dot_env::env parsed(const std::string_view contents)
+    {
+        auto environment = make_env();
+        EXPECT_TRUE(environment.load_from_buffer(contents));
+        return environment;
+    }
+
+    TEST(ParseValues, PlainQuotedAndExported)
+    {
+        const auto environment = parsed("PLAIN=hello\n"
+                                        "QUOTED=\"hello world\"\n"
+                                        "export EXPORTED=also accepted\n"
+                                        "  INDENTED = spaced  \n"
+                                        "# COMMENTED=no\n");
+        EXPECT_EQ(environment.get_view("PLAIN"), "hello");
+        EXPECT_EQ(environment.get_view("QUOTED"), "hello world");
+        EXPECT_EQ(environment.get_view("EXPORTED"), "also accepted");
+        EXPECT_EQ(environment.get_view("INDENTED"), "spaced");
+        EXPECT_FALSE(environment.get_view("COMMENTED").has_value());
+        EXPECT_FALSE(environment.get_view("export EXPORTED").has_value());
+    }
+
+    TEST(ParseValues, InlineCommentsNeedLeadingWhitespace)
+    {
+        const auto environment = parsed("A=value # a comment\n"
+                                        "URL=https://example.com/#anchor\n"
+                                        "QUOTED=\"keeps # inside\" # but not here\n");
+        EXPECT_EQ(environment.get_view("A"), "value");
+        EXPECT_EQ(environment.get_view("URL"), "https://example.com/#anchor");
+        EXPECT_EQ(environment.get_view("QUOTED"), "keeps # inside");
+    }
+
+    TEST(ParseValues, DoubleQuotesDecodeEscapes)
+    {
+        const auto environment =
+            parsed(R"(ESCAPED="tab\tnewline\n\"quote\" backslash\\ other\q")" "\n");
+        EXPECT_EQ(environment.get_view("ESCAPED"),
+                  "tab\tnewline\n\"quote\" backslash\\ other\\q");
+    }
+
+    TEST(ParseValues, SingleQuotesAreLiteral)
+    {
+        auto environment = make_env(dot_env::interpolation_mode::eager);
+        ASSERT_TRUE(environment.load_from_buffer(std::string_view(
+            R"(NAME=x)" "\n" R"(LITERAL='no ${NAME} and no \n escapes')" "\n")));
+        EXPECT_EQ(environment.get_view("LITERAL"), R"(no ${NAME} and no \n escapes)");
+    }
+
+    TEST(ParseValues, QuotedValuesSpanLines)
+    {
+        const auto environment = parsed("CERTIFICATE=\"-----BEGIN-----\n"
+                                        "MIIB\n"
+                                        "-----END-----\"\n"
+                                        "JSON='{\n  \"a\": 1\n}'\n"
+                                        "AFTER=1\n");
+        EXPECT_EQ(environment.get_view("CERTIFICATE"),
+                  "-----BEGIN-----\nMIIB\n-----END-----");
+        EXPECT_EQ(environment.get_view("JSON"), "{\n  \"a\": 1\n}");
+        EXPECT_EQ(environment.get_view("AFTER"), "1");
+        EXPECT_FALSE(environment.get_view("MIIB").has_value());
+    }
+
+    TEST(ParseValues, UnterminatedQuoteStaysOnItsLine)
+    {
+        const auto environment = parsed("A=1\nOPEN=\"never closed\nB=2\n");
+        EXPECT_EQ(environment.get_view("A"), "1");
+        EXPECT_EQ(environment.get_view("OPEN"), "\"never closed");
+        EXPECT_EQ(environment.get_view("B"), "2");
+    }
+
+    TEST(ParseValues, CrlfLineEndings)
+    {
+        const auto environment = parsed("A=1\r\nB=\"two\"\r\nC=three # note\r\n");
+        EXPECT_EQ(environment.get_view("A"), "1");
+        EXPECT_EQ(environment.get_view("B"), "two");
+        EXPECT_EQ(environment.get_view("C"), "three");
+    }
+
+    // Large enough for parallel slices and several stream windows, with
+    // quoted values that span lines wherever the boundaries happen to fall
+    TEST(ParseValues, EveryLoaderAgreesOnMultilineValues)
+    {
+        std::string contents;
+        for (std::size_t i = 0; contents.size() < 5 * 1024 * 1024; ++i)
+        {
+            const auto n = std::to_string(i);
+            if (i % 7 == 0)
+                contents += "BLOCK_" + n + "=\"first " + n + "\nKEY_IN_QUOTE_" + n +
+                    "=no\nlast \\\"" + n + "\\\"\"\n";
+            else if (i % 11 == 0)
+                contents += "LITERAL_" + n + "='a\n#not a comment\nb'\n";
+            else
+                contents += "KEY_" + n + "=value_" + n + " # comment\n";
+        }
+
+        const temp_file file(contents);
+        const auto serial = parsed(contents).freeze();
+
+        auto threaded = make_env();
+        threaded.set_parse_threads(4);
+        ASSERT_TRUE(threaded.load_env(file.name()));
+
+        auto streamed = make_env();
+        std::istringstream in(contents);
+        ASSERT_TRUE(streamed.load_from_stream(in));
+
+        EXPECT_EQ(serial.get_view("BLOCK_7"), "first 7\nKEY_IN_QUOTE_7=no\nlast \"7\"");
+        EXPECT_FALSE(serial.get_view("KEY_IN_QUOTE_7").has_value());
+        EXPECT_TRUE(dot_env::env_snapshot::diff(serial, threaded.freeze()).empty());
+        EXPECT_TRUE(dot_env::env_snapshot::diff(serial, streamed.freeze()).empty());
+    }
+} // namespace
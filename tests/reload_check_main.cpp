@@ -0,0 +1,223 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "env.hpp"
+
+namespace
+{
+    constexpr std::size_t key_count = 24;
+    // Lines in the initial file; about one line in 64 ends a chunk, so the
+    // file spans several chunks that edits can move past each other
+    constexpr std::size_t initial_lines = 400;
+
+    [[nodiscard]] std::string key_name(const std::size_t i)
+    {
+        return "DOT_ENV_CHECK_" + std::to_string(i);
+    }
+
+    // A line assigning a random key a mix of text, references, defaults
+    // and self-references, so edits create and break cycles
+    [[nodiscard]] std::string random_line(std::mt19937_64& rng)
+    {
+        std::string line = key_name(rng() % key_count) + "=";
+        const std::size_t parts = rng() % 4;
+        for (std::size_t p = 0; p < parts; ++p)
+        {
+            line += "${" + key_name(rng() % key_count);
+            line += rng() % 2 == 0 ? "}" : ":-d}";
+            line += static_cast<char>('a' + rng() % 26);
+        }
+        if (parts == 0)
+            line += "v";
+        return line;
+    }
+
+    // Moves a run of lines elsewhere, or swaps two runs, so unchanged
+    // chunks end up in a different order
+    void move_lines(std::vector<std::string>& lines, std::mt19937_64& rng)
+    {
+        if (lines.size() < 2)
+            return;
+
+        const std::size_t length = 1 + rng() % std::min<std::size_t>(lines.size() / 2, 128);
+        const std::size_t from = rng() % (lines.size() - length + 1);
+        const auto first = lines.begin() + static_cast<std::ptrdiff_t>(from);
+        const auto last = first + static_cast<std::ptrdiff_t>(length);
+        if (rng() % 2 == 0 && lines.size() - from - length >= length)
+        {
+            // Swap with an equally long run further down
+            const std::size_t to =
+                from + length + rng() % (lines.size() - from - 2 * length + 1);
+            std::swap_ranges(first, last, lines.begin() + static_cast<std::ptrdiff_t>(to));
+            return;
+        }
+
+        std::vector<std::string> run(std::make_move_iterator(first), std::make_move_iterator(last));
+        lines.erase(first, last);
+        const std::size_t to = rng() % (lines.size() + 1);
+        lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(to),
+                     std::make_move_iterator(run.begin()), std::make_move_iterator(run.end()));
+    }
+
+    // Replaces, inserts, removes or moves a few lines, keeping the rest, so
+    // the reload reuses unchanged chunks
+    void edit(std::vector<std::string>& lines, std::mt19937_64& rng)
+    {
+        const std::size_t edits = 1 + rng() % 3;
+        for (std::size_t e = 0; e < edits; ++e)
+        {
+            const std::size_t at = lines.empty() ? 0 : rng() % lines.size();
+            switch (rng() % 5)
+            {
+            case 3:
+            case 4:
+                move_lines(lines, rng);
+                break;
+            case 0:
+                if (!lines.empty())
+                {
+                    lines[at] = random_line(rng);
+                    break;
+                }
+                [[fallthrough]];
+            case 1:
+                lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(at), random_line(rng));
+                break;
+            default:
+                if (!lines.empty())
+                    lines.erase(lines.begin() + static_cast<std::ptrdiff_t>(at));
+                break;
+            }
+        }
+    }
+
+    [[nodiscard]] std::string join(const std::vector<std::string>& lines)
+    {
+        std::string text;
+        for (const auto& line : lines)
+            text += line + "\n";
+        return text;
+    }
+
+    void print_diff(const dot_env::env_diff& diff)
+    {
+        for (const auto& key : diff.added)
+            std::cerr << " +" << key;
+        for (const auto& key : diff.changed)
+            std::cerr << " ~" << key;
+        for (const auto& key : diff.removed)
+            std::cerr << " -" << key;
+    }
+
+    [[nodiscard]] dot_env::env make_env(const dot_env::interpolation_mode mode)
+    {
+        dot_env::env environment;
+        environment.set_injection(dot_env::injection_mode::deferred);
+        environment.set_interpolation(mode);
+        environment.set_diagnostics(dot_env::severity::off);
+        return environment;
+    }
+} // namespace
+
+/**
+ * dot_env_reload_check [ITERATIONS] [SEED]
+ *
+ * Applies random edits, including moves and swaps of whole runs of lines
+ * across chunk boundaries, to a file of interpolated values and checks after
+ * every edit that env::reload_env() gives each key the same value as a
+ * fresh eager load and a fresh lazy load of the edited file. Exits with
+ * a failure and prints both versions of the file on the first mismatch.
+ */
+int main(const int argc, char** argv)
+{
+    if (argc > 3)
+    {
+        std::cerr << "usage: dot_env_reload_check [ITERATIONS] [SEED]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+    const std::uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    std::mt19937_64 rng(seed);
+
+    const auto path = std::filesystem::temp_directory_path() /
+        ("dot_env_reload_check_" + std::to_string(seed) + ".env");
+    const auto write = [&](const std::string& text)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+    };
+
+    std::vector<std::string> lines;
+    for (std::size_t i = 0; i < initial_lines; ++i)
+        lines.push_back(random_line(rng));
+    auto reloaded = make_env(dot_env::interpolation_mode::eager);
+    write(join(lines));
+    reloaded.load_env(path.string());
+
+    int status = EXIT_SUCCESS;
+    for (std::uint64_t i = 0; i < iterations && status == EXIT_SUCCESS; ++i)
+    {
+        const std::string before = join(lines);
+        edit(lines, rng);
+        const std::string after = join(lines);
+        write(after);
+        const dot_env::env_snapshot previous = reloaded.freeze();
+        const auto reported = reloaded.reload_env();
+
+        auto eager = make_env(dot_env::interpolation_mode::eager);
+        eager.load_env(path.string());
+        auto lazy = make_env(dot_env::interpolation_mode::lazy);
+        lazy.load_env(path.string());
+
+        for (std::size_t k = 0; k < key_count; ++k)
+        {
+            const std::string key = key_name(k);
+            const auto expected = eager.get_view(key);
+            if (reloaded.get_view(key) == expected && lazy.get_view(key) == expected)
+                continue;
+
+            std::cerr << "dot_env_reload_check: " << key << " differs after edit " << i
+                      << "\nreload: " << reloaded.get_view(key).value_or("<unset>")
+                      << "\neager:  " << expected.value_or("<unset>")
+                      << "\nlazy:   " << lazy.get_view(key).value_or("<unset>")
+                      << "\n--- before\n" << before << "--- after\n" << after;
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        // The reported diff must name exactly the keys whose values differ
+        const auto expected_diff = dot_env::env_snapshot::diff(previous, eager.freeze());
+        if (status == EXIT_SUCCESS &&
+            (!reported.has_value() || reported->added != expected_diff.added ||
+             reported->changed != expected_diff.changed ||
+             reported->removed != expected_diff.removed))
+        {
+            std::cerr << "dot_env_reload_check: reload_env() reported the wrong diff after edit "
+                      << i << "\nreported:";
+            if (reported.has_value())
+                print_diff(*reported);
+            std::cerr << "\nexpected:";
+            print_diff(expected_diff);
+            std::cerr << "\n--- before\n" << before << "--- after\n" << after;
+            status = EXIT_FAILURE;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    if (status == EXIT_SUCCESS)
+        std::cout << "dot_env_reload_check: " << iterations << " edits consistent\n";
+    return status;
+}
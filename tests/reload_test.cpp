@@ -0,0 +1,125 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "reload_state.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env_test::make_env;
+    using dot_env_test::temp_file;
+
+    // A comment line that ends a reload chunk, so the lines around it are
+    // matched as separate blocks
+    [[nodiscard]] std::string boundary_line(const std::string_view tag)
+    {
+        for (unsigned i = 0;; ++i)
+        {
+            const std::string line = "#" + std::string(tag) + std::to_string(i);
+            if (dot_env::detail::split_chunks(line + "\nX=1\n").size() == 2)
+                return line + "\n";
+        }
+    }
+
+    TEST(ReloadEnv, ReportsOnlyChangedKeys)
+    {
+        temp_file file("A=1\nB=2\nC=3\n");
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_env(file.name()));
+
+        file.write("A=1\nB=20\nD=4\n");
+        const auto diff = environment.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_EQ(diff->added, std::vector<std::string>{"D"});
+        EXPECT_EQ(diff->changed, std::vector<std::string>{"B"});
+        EXPECT_EQ(diff->removed, std::vector<std::string>{"C"});
+        EXPECT_EQ(environment.get_view("B"), "20");
+        EXPECT_FALSE(environment.get_view("C").has_value());
+    }
+
+    TEST(ReloadEnv, UnchangedFileGivesEmptyDiff)
+    {
+        temp_file file("A=1\n" + boundary_line("a") + "B=2\n");
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_env(file.name()));
+
+        const auto diff = environment.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_TRUE(diff->empty());
+    }
+
+    TEST(ReloadEnv, SwappedChunksReassignLastWins)
+    {
+        const std::string first = "X=1\n" + boundary_line("a");
+        const std::string second = "X=2\n" + boundary_line("b");
+        temp_file file(first + second);
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_env(file.name()));
+        ASSERT_EQ(environment.get_view("X"), "2");
+
+        file.write(second + first);
+        const auto diff = environment.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_EQ(environment.get_view("X"), "1");
+        EXPECT_EQ(diff->changed, std::vector<std::string>{"X"});
+    }
+
+    TEST(ReloadEnv, MovedLineMatchesFreshLoad)
+    {
+        const std::string head = "A=head\n" + boundary_line("h");
+        const std::string middle = "B=middle\nA=middle\n" + boundary_line("m");
+        const std::string tail = "C=tail\n" + boundary_line("t");
+        temp_file file(head + middle + tail);
+        auto environment = make_env();
+        ASSERT_TRUE(environment.load_env(file.name()));
+        ASSERT_EQ(environment.get_view("A"), "middle");
+
+        // Move the first chunk to the end, past the other assignment of A
+        file.write(middle + tail + head);
+        ASSERT_TRUE(environment.reload_env().has_value());
+
+        auto fresh = make_env();
+        ASSERT_TRUE(fresh.load_env(file.name()));
+        for (const auto* key : {"A", "B", "C"})
+            EXPECT_EQ(environment.get_view(key), fresh.get_view(key)) << key;
+        EXPECT_EQ(environment.get_view("A"), "head");
+    }
+
+    TEST(ReloadEnv, ReexpandsDependentsOfChangedValues)
+    {
+        temp_file file("URL=http://${HOST}/\nHOST=a\n");
+        auto environment = make_env(dot_env::interpolation_mode::eager);
+        ASSERT_TRUE(environment.load_env(file.name()));
+        ASSERT_EQ(environment.get_view("URL"), "http://a/");
+
+        file.write("URL=http://${HOST}/\nHOST=b\n");
+        const auto diff = environment.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_EQ(environment.get_view("URL"), "http://b/");
+        EXPECT_EQ(diff->changed, (std::vector<std::string>{"HOST", "URL"}));
+    }
+
+    TEST(ReloadEnv, NewSourceWithSameExpansionIsNotReported)
+    {
+        temp_file file("A=v\nB=v\n");
+        auto environment = make_env(dot_env::interpolation_mode::eager);
+        ASSERT_TRUE(environment.load_env(file.name()));
+
+        file.write("A=v\nB=${A}\n");
+        const auto diff = environment.reload_env();
+        ASSERT_TRUE(diff.has_value());
+        EXPECT_TRUE(diff->empty());
+        EXPECT_EQ(environment.get_view("B"), "v");
+    }
+
+    TEST(ReloadEnv, WithoutLoadedFileReturnsNothing)
+    {
+        auto environment = make_env();
+        EXPECT_FALSE(environment.reload_env().has_value());
+    }
+} // namespace
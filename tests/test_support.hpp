@@ -0,0 +1,133 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#ifndef DOT_ENV_TEST_SUPPORT_HPP
+#define DOT_ENV_TEST_SUPPORT_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "env.hpp"
+
+namespace dot_env_test
+{
+    /**
+     * A file in the temporary directory, removed again on destruction. Each
+     * one gets a distinct name, so tests can run in parallel processes.
+     */
+    class temp_file
+    {
+    public:
+        explicit temp_file(const std::string_view contents = {},
+                           const std::string_view suffix = ".env")
+        {
+            static const unsigned process = std::random_device{}();
+            static std::atomic<unsigned> counter = 0;
+            path_ = std::filesystem::temp_directory_path() /
+                ("dot_env_test_" + std::to_string(process) + "_" +
+                 std::to_string(counter++) + std::string(suffix));
+            write(contents);
+        }
+
+        temp_file(const temp_file&) = delete;
+        temp_file& operator=(const temp_file&) = delete;
+
+        ~temp_file()
+        {
+            std::error_code error;
+            std::filesystem::remove(path_, error);
+        }
+
+        void write(const std::string_view contents) const
+        {
+            std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+            out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+
+        [[nodiscard]] const std::filesystem::path& path() const noexcept
+        {
+            return path_;
+        }
+
+        [[nodiscard]] std::string name() const
+        {
+            return path_.string();
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    /**
+     * Sets a process environment variable for the lifetime of the object
+     * and restores the previous state afterwards.
+     */
+    class scoped_system_variable
+    {
+    public:
+        scoped_system_variable(std::string name, const std::string_view value) :
+            name_(std::move(name))
+        {
+            if (const char* previous = std::getenv(name_.c_str()))
+                previous_ = previous;
+            set(value);
+        }
+
+        scoped_system_variable(const scoped_system_variable&) = delete;
+        scoped_system_variable& operator=(const scoped_system_variable&) = delete;
+
+        ~scoped_system_variable()
+        {
+            if (previous_.has_value())
+                set(*previous_);
+            else
+                unset();
+        }
+
+        void set(const std::string_view value) const
+        {
+            const std::string copy(value);
+#ifdef _WIN32
+            _putenv_s(name_.c_str(), copy.c_str());
+#else
+            setenv(name_.c_str(), copy.c_str(), 1);
+#endif
+        }
+
+        void unset() const
+        {
+#ifdef _WIN32
+            _putenv_s(name_.c_str(), "");
+#else
+            unsetenv(name_.c_str());
+#endif
+        }
+
+    private:
+        std::string name_;
+        std::optional<std::string> previous_;
+    };
+
+    /**
+     * An env that never touches the process environment, as most tests
+     * want.
+     */
+    [[nodiscard]] inline dot_env::env
+    make_env(const dot_env::interpolation_mode mode = dot_env::interpolation_mode::none)
+    {
+        dot_env::env environment;
+        environment.set_injection(dot_env::injection_mode::deferred);
+        environment.set_interpolation(mode);
+        return environment;
+    }
+} // namespace dot_env_test
+
+#endif // DOT_ENV_TEST_SUPPORT_HPP
@@ -0,0 +1,150 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "env_watcher.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    using dot_env::concurrent_env;
+    using dot_env::env_diff;
+    using dot_env::env_snapshot;
+    using dot_env::env_watcher;
+    using dot_env_test::temp_file;
+
+    TEST(EnvWatcher, FirstRefreshPublishesTheFile)
+    {
+        temp_file file("A=1\n");
+        concurrent_env target;
+        env_watcher watcher(target, file.path());
+
+        EXPECT_TRUE(watcher.refresh());
+        EXPECT_EQ(target.get("A"), "1");
+        EXPECT_FALSE(watcher.refresh());
+    }
+
+    TEST(EnvWatcher, KeyCallbacksSeeOnlyTheirKey)
+    {
+        temp_file file("A=1\nB=2\n");
+        concurrent_env target;
+        env_watcher watcher(target, file.path());
+        ASSERT_TRUE(watcher.refresh());
+
+        std::vector<std::string> seen;
+        watcher.on_change("B", [&](const std::string_view key,
+                                   const std::optional<std::string_view> value)
+        {
+            seen.push_back(std::string(key) + "=" +
+                           std::string(value.value_or("<removed>")));
+        });
+
+        file.write("A=10\nB=20\n");
+        ASSERT_TRUE(watcher.refresh());
+        file.write("A=10\n");
+        ASSERT_TRUE(watcher.refresh());
+        EXPECT_EQ(seen, (std::vector<std::string>{"B=20", "B=<removed>"}));
+    }
+
+    TEST(EnvWatcher, ReloadCallbackGetsDiffAndSnapshot)
+    {
+        temp_file file("A=1\n");
+        concurrent_env target;
+        env_watcher watcher(target, file.path());
+        ASSERT_TRUE(watcher.refresh());
+
+        int reloads = 0;
+        const auto id = watcher.on_reload([&](const env_diff& diff,
+                                              const env_snapshot& current)
+        {
+            ++reloads;
+            EXPECT_EQ(diff.added, std::vector<std::string>{"C"});
+            EXPECT_EQ(current.get_view("C"), "3");
+        });
+
+        file.write("A=1\nC=3\n");
+        ASSERT_TRUE(watcher.refresh());
+        EXPECT_EQ(reloads, 1);
+
+        watcher.unsubscribe(id);
+        file.write("A=2\n");
+        ASSERT_TRUE(watcher.refresh());
+        EXPECT_EQ(reloads, 1);
+    }
+
+    TEST(EnvWatcher, CallbackMayRefreshAgain)
+    {
+        temp_file file("N=0\n");
+        concurrent_env target;
+        env_watcher watcher(target, file.path());
+        ASSERT_TRUE(watcher.refresh());
+
+        // Each callback bumps the file and refreshes from inside the
+        // dispatch; the nested reloads arrive in order after it returns
+        std::vector<std::string> seen;
+        watcher.on_change("N", [&](std::string_view,
+                                   const std::optional<std::string_view> value)
+        {
+            seen.emplace_back(value.value_or(""));
+            if (seen.size() < 3)
+            {
+                file.write("N=" + std::to_string(seen.size() + 1) + "\n");
+                EXPECT_TRUE(watcher.refresh());
+                EXPECT_EQ(target.get("N"), std::to_string(seen.size() + 1));
+            }
+        });
+
+        file.write("N=1\n");
+        ASSERT_TRUE(watcher.refresh());
+        EXPECT_EQ(seen, (std::vector<std::string>{"1", "2", "3"}));
+    }
+
+    TEST(EnvWatcher, BackgroundThreadPicksUpEdits)
+    {
+        temp_file file("A=1\n");
+        concurrent_env target;
+        env_watcher watcher(target, file.path());
+
+        std::mutex mutex;
+        std::condition_variable published;
+        std::optional<std::string> seen;
+        watcher.on_change("A", [&](std::string_view,
+                                   const std::optional<std::string_view> value)
+        {
+            const std::scoped_lock lock(mutex);
+            seen = std::string(value.value_or(""));
+            published.notify_all();
+        });
+
+        watcher.start();
+        file.write("A=2\n");
+
+        std::unique_lock lock(mutex);
+        EXPECT_TRUE(published.wait_for(lock, std::chrono::seconds(10),
+                                       [&] { return seen == "2"; }));
+        lock.unlock();
+        watcher.stop();
+        EXPECT_EQ(target.get("A"), "2");
+    }
+
+    TEST(EnvWatcher, LayeredTargetIsNotRepublished)
+    {
+        temp_file base("A=1\n");
+        temp_file local("B=2\n");
+        concurrent_env target;
+        ASSERT_EQ(target.load_layers({base.name(), local.name()}), 2u);
+
+        env_watcher watcher(target, base.path());
+        EXPECT_FALSE(watcher.refresh());
+        EXPECT_EQ(target.get("B"), "2");
+    }
+} // namespace
@@ -0,0 +1,57 @@
+﻿//
+// Created by blomq on 2026-10-14.
+//
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+#include "env.hpp"
+#include "env_snapshot.hpp"
+
+/**
+ * dot_env_cache SOURCE [CACHE]
+ *
+ * Parses SOURCE as a .env file and writes its binary cache to CACHE, which
+ * defaults to SOURCE with ".bin" appended. Values are stored as written;
+ * ${NAME} references are left for the loading env to expand.
+ */
+int main(const int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " SOURCE [CACHE]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::filesystem::path source = std::filesystem::absolute(argv[1]);
+    std::filesystem::path cache = argc == 3 ? std::filesystem::path(argv[2]) : source;
+    if (argc == 2)
+        cache += ".bin";
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(source, error))
+    {
+        std::cerr << "Env file not found: " << source << '\n';
+        return EXIT_FAILURE;
+    }
+
+    dot_env::env loader;
+    loader.set_injection(dot_env::injection_mode::deferred);
+    if (!loader.load_env(source.string(), false))
+    {
+        std::cerr << "Failed to load env file: " << source << '\n';
+        return EXIT_FAILURE;
+    }
+
+    const dot_env::env_snapshot snapshot = loader.freeze();
+    if (!snapshot.save_cache(cache, source))
+    {
+        std::cerr << "Failed to write env cache: " << cache << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Wrote " << snapshot.size() << " variables to " << cache << '\n';
+    return EXIT_SUCCESS;
+}